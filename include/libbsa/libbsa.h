@@ -25,9 +25,10 @@
     @file libbsa.h
     @brief This file contains the API frontend.
 
-    @note libbsa is *not* thread safe. Thread safety is a goal, but one that
-          has not yet been achieved. Bear this in mind if using it in a
-          multi-threaded client.
+    @note Functions that read from a handle can be called on the same handle
+          from multiple threads at once. bsa_save() and bsa_close() must not
+          be called on a handle while any other function is using it. See
+          @ref thread_sec for details.
 
     @section var_sec Variable Types
 
@@ -57,7 +58,8 @@
     Data returned by a function lasts until a function is called which returns
     data of the same type (eg. a string is stored until the client calls
     another function which returns a string, an integer array lasts until
-    another integer array is returned, etc.).
+    another integer array is returned, etc.). This is tracked separately for
+    each thread, see @ref thread_sec.
 
     All allocated memory is freed when bsa_close() is called, except the string
     returned by bsa_get_error_message(), which is allocated for the lifetime of
@@ -66,6 +68,40 @@
     While the source path given in a bsa_asset object must be valid until the
     next call to bsa_save(), the memory allocated by the client for the path
     string may be freed at any point after the object's use.
+
+    @section thread_sec Thread Safety
+
+    Different handles can always be used from different threads at once.
+
+    Most functions that take a handle only read from it, and can be called on
+    the same handle from any number of threads at once. A few also change the
+    handle's state, but synchronise internally, so they can be called at the
+    same time as any of the functions that only read:
+      - bsa_set_extraction_threads() sets a thread count that is read and
+        written atomically. Extractions that have already started keep using
+        the count they started with.
+      - bsa_set_asset_cache_size() and bsa_get_asset_cache_stats() lock the
+        handle's asset cache, as do extractions that use it.
+      - bsa_release_asset_paths() locks the handle's per-thread arrays of
+        paths, and only frees the calling thread's array.
+      - bsa_release_asset_view() locks the handle's views. A view must not
+        be released while another thread is still reading its data.
+
+    bsa_save() and bsa_close() must not be called on a handle while any other
+    function is using it, including an asynchronous extraction that hasn't
+    been closed.
+
+    Returned data is kept separately for each thread, so one thread's calls
+    never free data that another thread is using. For example, the array
+    output by bsa_get_assets() lasts until the same thread gets another
+    array from the same handle, calls bsa_release_asset_paths() on it, or the
+    handle is closed. A thread that stops using a handle before it is closed,
+    eg. a short-lived or pooled thread, should call bsa_release_asset_paths()
+    first, otherwise its array is kept until the handle is closed, so a
+    long-lived handle used from many such threads keeps growing. Error
+    messages are also kept separately for each thread, so
+    bsa_get_error_message() gives the last error encountered by the calling
+    thread.
 */
 
 #ifndef __LIBBSA_H__
@@ -118,11 +154,60 @@ extern "C"
     @details Holds an index of all the files inside a BSA file. Abstracts the
              definition of libbsa' internal state while still providing type
              safety across the library's functions. Multiple handles can also
-             be made for each BSA file, though it should be kept in mind that
-             libbsa is not thread-safe.
+             be made for each BSA file, and a handle can be read from by
+             multiple threads at once.
 */
     typedef struct _bsa_handle_int * bsa_handle;
 
+/**
+    @brief A structure that holds a set of BSAs that are searched together.
+    @details Holds a handle for each BSA in the set, and an index of which BSA
+             each asset path in the set resolves to. BSAs are given in load
+             order, and an asset that is in more than one BSA resolves to the
+             last of them, as it would in-game.
+*/
+    typedef struct _bsa_archive_set_handle_int * bsa_archive_set_handle;
+
+/**
+    @brief A function that receives an asset's data a chunk at a time.
+    @details Used by bsa_extract_asset_to_callback(). The chunk is only valid
+             until the function returns.
+    @param data The chunk of asset data.
+    @param size The size of the chunk.
+    @param userData The pointer passed to bsa_extract_asset_to_callback().
+*/
+    typedef void (*bsa_chunk_callback)(const uint8_t * data,
+                                       size_t size,
+                                       void * userData);
+
+/**
+    @brief A structure that holds the state of an asynchronous extraction.
+    @details Created by bsa_extract_assets_async(), and tracks the background
+             work that extracts the assets.
+*/
+    typedef struct _bsa_extraction_int * bsa_extraction_handle;
+
+/**
+    @brief A function that receives an asset extracted asynchronously.
+    @details Used by bsa_extract_assets_async(). It is called once for each
+             asset, in whatever order the assets are ready, and may be called
+             from several threads at once. The data is only valid until the
+             function returns. If the asset couldn't be extracted,
+             bsa_get_error_message() can be called in the function to get
+             details of the error.
+    @param index The index of the asset in the array of paths given to
+                 bsa_extract_assets_async().
+    @param returnCode A return code for the asset's extraction.
+    @param data The asset's data, or `NULL` if it couldn't be extracted.
+    @param size The size of the asset's data.
+    @param userData The pointer passed to bsa_extract_assets_async().
+*/
+    typedef void (*bsa_asset_callback)(size_t index,
+                                       unsigned int returnCode,
+                                       const uint8_t * data,
+                                       size_t size,
+                                       void * userData);
+
     /*********************//**
         @name Return Codes
         @brief Error codes signify an issue that caused a function to exit
@@ -220,9 +305,10 @@ extern "C"
     /**
        @brief Returns the message for the last error or warning encountered.
        @details Outputs a string giving the a message containing the details of
-                the last error or warning encountered by a function. Each time
-                this function is called, the memory for the previous message is
-                freed, so only one error message is available at any one time.
+                the last error or warning encountered by a function called
+                from the calling thread. Each time this function is called,
+                the memory for the previous message is freed, so only one
+                error message is available to each thread at any one time.
        @param details A pointer to the error details string outputted by the
                       function.
        @returns A return code.
@@ -240,6 +326,9 @@ extern "C"
         @details Opens a BSA file, outputting a handle that holds an index of
                  its contents. If the file doesn't exist then a handle for a
                  new file will be created. You can create multiple handles.
+                 Where possible, the BSA file is memory-mapped for the
+                 lifetime of the handle, and asset data is read from the
+                 mapping.
         @param bh A pointer to the handle that is created by the function.
         @param path A string containing the relative or absolute path to the
                     BSA file to be opened.
@@ -295,6 +384,50 @@ extern "C"
                                        const char * const ** const assetPaths,
                                        size_t * const numAssets);
 
+    /**
+        @brief Selectively outputs asset paths in a BSA using a glob.
+        @details Gets all the assets indexed in a handle with internal paths
+                 that match the given glob, eg. `meshes\\armor\\*.nif`.
+                 Matching is case-insensitive, and forward slashes match
+                 backslashes. `?` matches any one character other than a path
+                 separator, `*` matches any number of characters other than a
+                 path separator, and `**` matches any number of characters.
+                 Globs that start with literal text are answered without
+                 checking every asset in the BSA, so are faster than
+                 equivalent regular expressions.
+        @param bh The handle the function acts on.
+        @param assetGlob The glob to match asset paths against.
+        @param assetPaths The outputted array of asset paths. If no matching
+                          assets are found, this will be `NULL`.
+        @param numAssets The size of the outputted array. If no matching assets
+                         are found, this will be `0`.
+        @returns A return code.
+    */
+    LIBBSA unsigned int bsa_get_assets_by_glob(bsa_handle bh,
+                                               const char * const assetGlob,
+                                               const char * const ** const assetPaths,
+                                               size_t * const numAssets);
+
+    /**
+        @brief Lists the contents of a folder in a BSA.
+        @details Gets the internal paths of the subfolders and assets directly
+                 inside the given folder, with subfolders first. Subfolder
+                 paths end in a backslash. Folder paths are case-insensitive,
+                 and forward slashes are treated as backslashes.
+        @param bh The handle the function acts on.
+        @param folderPath The internal path of the folder. An empty string
+                          lists the root of the BSA.
+        @param contentPaths The outputted array of subfolder and asset paths.
+                            If the folder is empty, this will be `NULL`.
+        @param numContents The size of the outputted array.
+        @returns A return code. If the folder doesn't exist,
+                 `LIBBSA_ERROR_INVALID_ARGS` is returned.
+    */
+    LIBBSA unsigned int bsa_get_folder_contents(bsa_handle bh,
+                                                const char * const folderPath,
+                                                const char * const ** const contentPaths,
+                                                size_t * const numContents);
+
     /**
         @brief Checks if a specific asset is in a BSA.
         @param bh The handle the function acts on.
@@ -307,6 +440,39 @@ extern "C"
                                            const char * const assetPath,
                                            bool * const result);
 
+    /**
+        @brief Checks if each of a list of assets is in a BSA.
+        @details This gives the same results as calling bsa_contains_asset()
+                 for each asset, but is faster when checking many assets. Once
+                 the BSA's asset list has been read, e.g. by bsa_get_assets(),
+                 the paths are sorted and then looked up in a single pass.
+        @param bh The handle the function acts on.
+        @param assetPaths An array of the internal asset paths to look for.
+        @param numAssets The size of the assetPaths array.
+        @param results An array of size numAssets, allocated by the client.
+                       Each element is set to `true` if the asset with the
+                       path at the same index in assetPaths was found, and
+                       `false` otherwise.
+        @returns A return code.
+    */
+    LIBBSA unsigned int bsa_contains_assets(bsa_handle bh,
+                                            const char * const * const assetPaths,
+                                            const size_t numAssets,
+                                            bool * const results);
+
+    /**
+        @brief Frees the calling thread's array of paths.
+        @details Each thread's array of paths output by bsa_get_assets(),
+                 bsa_get_assets_by_glob(), bsa_get_folder_contents(),
+                 bsa_extract_assets() or bsa_extract_assets_by_glob() is
+                 otherwise kept until the same thread calls one of them again,
+                 or the handle is closed. Arrays output to other threads are
+                 unaffected. See @ref thread_sec.
+        @param bh The handle the function acts on.
+        @returns A return code.
+    */
+    LIBBSA unsigned int bsa_release_asset_paths(bsa_handle bh);
+
     /**@}*/
 
     /***************************************//**
@@ -339,6 +505,86 @@ extern "C"
                                            size_t * const numAssets,
                                            const bool overwrite);
 
+    /**
+        @brief Selectively extracts assets from a BSA using a glob.
+        @details Extracts all the assets with internal paths that match the
+                 given glob to the given destination path, maintaining the
+                 directory structure they had inside the BSA. Globs are matched
+                 as described for bsa_get_assets_by_glob().
+        @param bh The handle the function acts on.
+        @param assetGlob The glob to match asset paths against.
+        @param destPath The folder path to which assets should be extracted.
+        @param assetPaths An array of the internal paths of the assets
+                          extracted. If no assets are extracted, this will be
+                          `NULL`.
+        @param numAssets The size of the outputted array.
+        @param overwrite If an asset is to be extracted to a path that already
+                         exists, this decides what will happen. If `true`, the
+                         existing file will be overwritten, otherwise the asset
+                         will not be extracted.
+        @returns A return code.
+    */
+    LIBBSA unsigned int bsa_extract_assets_by_glob(bsa_handle bh,
+                                                   const char * const assetGlob,
+                                                   const char * const destPath,
+                                                   const char * const ** const assetPaths,
+                                                   size_t * const numAssets,
+                                                   const bool overwrite);
+
+    /**
+        @brief Sets the number of threads used to extract multiple assets.
+        @details bsa_extract_assets() extracts assets one at a time by
+                 default. If more than one thread is set, assets are
+                 extracted by a pool of worker threads, which each read,
+                 decompress and write out their own assets. If an asset fails
+                 to extract, the workers stop after their current asset, so
+                 some other matching assets may or may not have been
+                 extracted. The number of threads is also used by
+                 bsa_extract_assets_async() for its decompression workers,
+                 and by bsa_save() when it recompresses assets.
+        @param bh The handle the function acts on.
+        @param threads The number of threads to use. If `0`, one thread is
+                       used per hardware thread.
+        @returns A return code.
+    */
+    LIBBSA unsigned int bsa_set_extraction_threads(bsa_handle bh,
+                                                   const unsigned int threads);
+
+    /**
+        @brief Sets the size of the cache of uncompressed asset data.
+        @details bsa_extract_asset_to_memory(), bsa_get_asset_view() and
+                 bsa_calc_checksum() keep the uncompressed data of the assets
+                 they read in a cache, so that reading a compressed asset again
+                 doesn't decompress it again. When the cache is full, the
+                 least recently used assets are dropped from it. Assets that
+                 are stored uncompressed in a memory-mapped BSA are read
+                 directly and not cached. The cache is disabled by default.
+                 Asset views stay valid after their data is dropped from the
+                 cache.
+        @param bh The handle the function acts on.
+        @param size The maximum number of bytes of asset data to cache. If
+                    `0`, the cache is disabled and emptied.
+        @returns A return code.
+    */
+    LIBBSA unsigned int bsa_set_asset_cache_size(bsa_handle bh,
+                                                 const size_t size);
+
+    /**
+        @brief Gets statistics for the cache of uncompressed asset data.
+        @details Only reads of assets that go through the cache are counted,
+                 and the counts are kept when the cache size is changed.
+        @param bh The handle the function acts on.
+        @param hits The number of reads that found their asset in the cache.
+        @param misses The number of reads that didn't find their asset in
+                      the cache.
+        @param size The number of bytes of asset data currently cached.
+        @returns A return code.
+    */
+    LIBBSA unsigned int bsa_get_asset_cache_stats(bsa_handle bh,
+                                                  uint64_t * const hits,
+                                                  uint64_t * const misses,
+                                                  size_t * const size);
+
     /**
         @brief Extracts an asset from a BSA to the filesystem.
         @details Extracts the given asset to the given location. If a file
@@ -358,6 +604,23 @@ extern "C"
                                           const char * const destPath,
                                           const bool overwrite);
 
+    /**
+        @brief Extracts an asset from a BSA, passing its data to a callback.
+        @details Decompresses the given asset in chunks of at most 64 KiB,
+                 calling the callback with each chunk in order, so that large
+                 compressed assets can be processed without holding all of
+                 their uncompressed data in memory.
+        @param bh The handle the function acts on.
+        @param assetPath The path of the asset inside the BSA.
+        @param callback The function that receives the asset's data.
+        @param userData A pointer that is passed unchanged to the callback.
+        @returns A return code.
+    */
+    LIBBSA unsigned int bsa_extract_asset_to_callback(bsa_handle bh,
+                                                      const char * const assetPath,
+                                                      bsa_chunk_callback callback,
+                                                      void * userData);
+
     /**
         @brief Extracts an asset from a BSA into memory.
         @details Extracts the given asset to the output array.
@@ -372,6 +635,203 @@ extern "C"
                                                     const uint8_t ** const data,
                                                     size_t * size);
 
+    /**
+        @brief Gets a read-only view of an asset's data.
+        @details If the asset is stored uncompressed and the BSA is
+                 memory-mapped, the view points directly into the mapping and
+                 no memory is allocated. Otherwise, the asset's data is read
+                 (and decompressed if necessary) into memory owned by the
+                 handle. Either way, the view remains valid until it is passed
+                 to bsa_release_asset_view() or the handle is closed, and must
+                 not be written to.
+        @param bh The handle the function acts on.
+        @param assetPath The path of the asset inside the BSA.
+        @param data The outputted view of the asset's data.
+        @param size The size of the outputted view.
+        @returns A return code.
+    */
+    LIBBSA unsigned int bsa_get_asset_view(bsa_handle bh,
+                                           const char * const assetPath,
+                                           const uint8_t ** const data,
+                                           size_t * const size);
+
+    /**
+        @brief Releases an asset view.
+        @details Frees any memory allocated for the given view by
+                 bsa_get_asset_view(). Views that point into a memory-mapped
+                 BSA don't own any memory, so releasing them does nothing.
+        @param bh The handle the function acts on.
+        @param data The view to release.
+        @returns A return code.
+    */
+    LIBBSA unsigned int bsa_release_asset_view(bsa_handle bh,
+                                               const uint8_t * const data);
+
+    /**@}*/
+
+    /***************************************//**
+        @name Asynchronous Extraction Functions
+    *******************************************/
+    /**@{*/
+    /**
+        @brief Starts extracting assets from a BSA in the background.
+        @details Returns straight away, while a background thread reads the
+                 given assets in the order their data is stored in the BSA
+                 and a pool of worker threads decompresses them, calling the
+                 callback with each asset as soon as it's ready. The number of
+                 workers is set by bsa_set_extraction_threads(). An asset that
+                 isn't in the BSA or can't be extracted is passed to the
+                 callback with an error code, and doesn't stop the others. The
+                 BSA handle must not be closed until the extraction handle is.
+        @param bh The handle the function acts on.
+        @param assetPaths An array of the paths of the assets inside the BSA.
+                          It may be freed once the function returns.
+        @param numAssets The size of the assetPaths array.
+        @param callback The function that receives each asset's data.
+        @param userData A pointer that is passed unchanged to the callback.
+        @param eh A pointer to the extraction handle that is created by the
+                  function.
+        @returns A return code.
+    */
+    LIBBSA unsigned int bsa_extract_assets_async(bsa_handle bh,
+                                                 const char * const * const assetPaths,
+                                                 const size_t numAssets,
+                                                 bsa_asset_callback callback,
+                                                 void * userData,
+                                                 bsa_extraction_handle * const eh);
+
+    /**
+        @brief Waits for an asynchronous extraction to finish.
+        @details Returns once the callback has been called for every asset, or
+                 the extraction has been stopped by an error, in which case the
+                 error's code is returned.
+        @param eh The handle the function acts on.
+        @returns A return code.
+    */
+    LIBBSA unsigned int bsa_extraction_wait(bsa_extraction_handle eh);
+
+    /**
+        @brief Checks if an asynchronous extraction has finished.
+        @param eh The handle the function acts on.
+        @param result The result of the check: `true` if the extraction has
+                      finished, `false` otherwise.
+        @returns A return code.
+    */
+    LIBBSA unsigned int bsa_extraction_is_complete(bsa_extraction_handle eh,
+                                                   bool * const result);
+
+    /**
+        @brief Closes an asynchronous extraction handle.
+        @details If the extraction hasn't finished, it is cancelled: assets
+                 that haven't been started are skipped without calling the
+                 callback, and the function waits for the assets that are in
+                 progress before returning.
+        @param eh The handle to be destroyed.
+    */
+    LIBBSA void bsa_extraction_close(bsa_extraction_handle eh);
+
+    /**@}*/
+
+    /***************************************//**
+        @name Archive Set Functions
+    *******************************************/
+    /**@{*/
+    /**
+        @brief Initialise a new BSA set handle.
+        @details Opens each of the given BSA files, then builds a single index
+                 of which BSA each asset path resolves to, so that lookups
+                 against the set take the same time however many BSAs it
+                 holds.
+        @param sh A pointer to the handle that is created by the function.
+        @param paths An array of the relative or absolute paths of the BSA
+                     files to open, in load order.
+        @param numPaths The size of the paths array.
+        @returns A return code.
+    */
+    LIBBSA unsigned int bsa_archive_set_open(bsa_archive_set_handle * const sh,
+                                             const char * const * const paths,
+                                             const size_t numPaths);
+
+    /**
+        @brief Closes an existing BSA set handle.
+        @details Closes the set's BSA handles and frees any memory allocated
+                 during its use.
+        @param sh The handle to be destroyed.
+    */
+    LIBBSA void bsa_archive_set_close(bsa_archive_set_handle sh);
+
+    /**
+        @brief Gets the handle for one of the BSAs in a set.
+        @details The handle is owned by the set, and remains valid until the
+                 set is closed. It must not be passed to bsa_close().
+        @param sh The handle the function acts on.
+        @param index The index of the BSA in the array of paths that the set
+                     was opened with.
+        @param bh The outputted BSA handle.
+        @returns A return code.
+    */
+    LIBBSA unsigned int bsa_archive_set_get_archive(bsa_archive_set_handle sh,
+                                                    const size_t index,
+                                                    bsa_handle * const bh);
+
+    /**
+        @brief Checks if a specific asset is in any of the BSAs in a set.
+        @param sh The handle the function acts on.
+        @param assetPath The internal asset path to look for.
+        @param result The result of the check: `true` if the asset was found,
+                      `false` otherwise.
+        @returns A return code.
+    */
+    LIBBSA unsigned int bsa_archive_set_contains_asset(bsa_archive_set_handle sh,
+                                                       const char * const assetPath,
+                                                       bool * const result);
+
+    /**
+        @brief Gets which BSA in a set an asset resolves to.
+        @details If more than one BSA contains the asset, the last of them in
+                 load order is given.
+        @param sh The handle the function acts on.
+        @param assetPath The internal asset path to look for.
+        @param index The outputted index of the BSA in the array of paths that
+                     the set was opened with.
+        @returns A return code.
+    */
+    LIBBSA unsigned int bsa_archive_set_get_asset_archive(bsa_archive_set_handle sh,
+                                                          const char * const assetPath,
+                                                          size_t * const index);
+
+    /**
+        @brief Extracts an asset from the BSA in a set that it resolves to.
+        @details Behaves as bsa_extract_asset() does for that BSA.
+        @param sh The handle the function acts on.
+        @param assetPath The path of the asset inside the BSAs.
+        @param destPath The file path to which the asset should be extracted.
+        @param overwrite If the asset is to be extracted to a path that already
+                         exists, this decides what will happen. If `true`, the
+                         existing file will be overwritten, otherwise the asset
+                         will not be extracted.
+        @returns A return code.
+    */
+    LIBBSA unsigned int bsa_archive_set_extract_asset(bsa_archive_set_handle sh,
+                                                      const char * const assetPath,
+                                                      const char * const destPath,
+                                                      const bool overwrite);
+
+    /**
+        @brief Extracts an asset from the BSA in a set that it resolves to
+               into memory.
+        @details Behaves as bsa_extract_asset_to_memory() does for that BSA.
+        @param sh The handle the function acts on.
+        @param assetPath The path of the asset inside the BSAs.
+        @param data The output byte array containing the asset's data.
+        @param size The size of the output byte array.
+        @returns A return code.
+    */
+    LIBBSA unsigned int bsa_archive_set_extract_asset_to_memory(bsa_archive_set_handle sh,
+                                                                const char * const assetPath,
+                                                                const uint8_t ** const data,
+                                                                size_t * const size);
+
     /**@}*/
 
     /***************************************//**
@@ -381,8 +841,11 @@ extern "C"
     /**
         @brief Calculates the CRC32 of an asset.
         @details Calculates the 32-bit CRC of the given asset without
-                 extracting it. The CRC parameters are those used by the
-                 Boost.CRC library's `crc_32_type` type.
+                 extracting it. Compressed assets are decompressed in chunks
+                 as the CRC is calculated, so their uncompressed data is never
+                 held in memory, unless the asset cache is enabled. The CRC
+                 parameters are those used by the Boost.CRC library's
+                 `crc_32_type` type, and by zlib's `crc32()`.
         @param bh The handle the function acts on.
         @param assetPath The internal asset path to calculate the CRC32 of.
         @param checksum The calculated checksum.
@@ -392,6 +855,23 @@ extern "C"
                                           const char * const assetPath,
                                           uint32_t * const checksum);
 
+    /**
+        @brief Sets the directory that asset indices are cached in.
+        @details Building the index of a BSA's assets involves decoding all
+                 their paths, so when a directory is set, the index for each
+                 BSA is cached there when it is first built, in a file named
+                 after the BSA's path. Handles opened later for the same BSA
+                 read the cached index instead, as long as the BSA's size,
+                 modification time and the checksum of its header and records
+                 are unchanged. Problems reading or writing the cache are
+                 ignored. Caching is disabled by default, and affects all
+                 handles.
+        @param directory The path to an existing directory, or `NULL` or an
+                         empty string to disable caching.
+        @returns A return code.
+    */
+    LIBBSA unsigned int bsa_set_index_cache_directory(const char * const directory);
+
     /**@}*/
 
 #ifdef __cplusplus
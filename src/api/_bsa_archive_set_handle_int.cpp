@@ -0,0 +1,74 @@
+/*  libbsa
+
+A library for reading and writing BSA files.
+
+Copyright (C) 2012-2013    WrinklyNinja
+
+This file is part of libbsa.
+
+libbsa is free software: you can redistribute
+it and/or modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+libbsa is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with libbsa.  If not, see
+<http://www.gnu.org/licenses/>.
+*/
+
+
+#include "_bsa_archive_set_handle_int.h"
+#include "asset_path.h"
+
+using namespace libbsa;
+
+_bsa_archive_set_handle_int::_bsa_archive_set_handle_int(const std::vector<boost::filesystem::path>& paths) {
+    try {
+        archives.reserve(paths.size());
+        for (const auto& path : paths)
+            archives.push_back(new _bsa_handle_int(path));
+
+        // Later archives override earlier ones, so record each path's last
+        // archive.
+        for (size_t i = 0; i < archives.size(); ++i) {
+            for (auto& path : archives[i]->getBsa()->GetNormalisedAssetPaths())
+                assetArchives[std::move(path)] = i;
+        }
+    }
+    catch (...) {
+        for (const auto archive : archives)
+            delete archive;
+        throw;
+    }
+}
+
+_bsa_archive_set_handle_int::~_bsa_archive_set_handle_int() {
+    for (const auto archive : archives)
+        delete archive;
+}
+
+size_t _bsa_archive_set_handle_int::getArchiveCount() const {
+    return archives.size();
+}
+
+_bsa_handle_int * _bsa_archive_set_handle_int::getArchive(size_t index) const {
+    return archives.at(index);
+}
+
+bool _bsa_archive_set_handle_int::findAsset(const std::string& assetPath, size_t& archiveIndex) const {
+    static thread_local std::string normalisedPath;
+    NormaliseAssetPath(assetPath.data(), assetPath.length(), normalisedPath);
+
+    auto it = assetArchives.find(normalisedPath);
+    if (it == assetArchives.end())
+        return false;
+
+    archiveIndex = it->second;
+
+    return true;
+}
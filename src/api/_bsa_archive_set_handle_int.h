@@ -0,0 +1,57 @@
+/*  libbsa
+
+A library for reading and writing BSA files.
+
+Copyright (C) 2012-2013    WrinklyNinja
+
+This file is part of libbsa.
+
+libbsa is free software: you can redistribute
+it and/or modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+libbsa is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with libbsa.  If not, see
+<http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef LIBBSA_BSA_ARCHIVE_SET_HANDLE_INT_H
+#define LIBBSA_BSA_ARCHIVE_SET_HANDLE_INT_H
+
+#include "_bsa_handle_int.h"
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/filesystem/path.hpp>
+
+// A set of BSAs that are searched together, in load order, so that each
+// asset path resolves to the last BSA that contains it.
+struct _bsa_archive_set_handle_int {
+public:
+    _bsa_archive_set_handle_int(const std::vector<boost::filesystem::path>& paths);
+    ~_bsa_archive_set_handle_int();
+
+    size_t getArchiveCount() const;
+    _bsa_handle_int * getArchive(size_t index) const;
+
+    // Outputs the index of the archive that the asset resolves to, returning
+    // false if no archive in the set contains it.
+    bool findAsset(const std::string& assetPath, size_t& archiveIndex) const;
+private:
+    std::vector<_bsa_handle_int*> archives;
+
+    // Maps each normalised asset path in the set to the index of the archive
+    // that it resolves to.
+    std::unordered_map<std::string, uint32_t> assetArchives;
+};
+
+#endif
@@ -0,0 +1,72 @@
+/*  libbsa
+
+A library for reading and writing BSA files.
+
+Copyright (C) 2012-2013    WrinklyNinja
+
+This file is part of libbsa.
+
+libbsa is free software: you can redistribute
+it and/or modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+libbsa is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with libbsa.  If not, see
+<http://www.gnu.org/licenses/>.
+*/
+
+
+
+#include "_bsa_extraction_int.h"
+
+using namespace libbsa;
+
+_bsa_extraction_int::_bsa_extraction_int(const GenericBsa& bsa,
+                                         const std::vector<std::string>& assetPaths,
+                                         unsigned int threadCount,
+                                         const GenericBsa::AssetHandler& handler) :
+    cancelled(false),
+    complete(false) {
+    thread = std::thread([this, &bsa, assetPaths, threadCount, handler]() {
+        try {
+            bsa.Extract(assetPaths, handler, threadCount, cancelled);
+        }
+        catch (...) {
+            failure = std::current_exception();
+        }
+        complete = true;
+    });
+}
+
+_bsa_extraction_int::~_bsa_extraction_int() {
+    cancel();
+    try {
+        wait();
+    }
+    catch (...) {}
+}
+
+void _bsa_extraction_int::wait() {
+    {
+        std::lock_guard<std::mutex> lock(threadMutex);
+        if (thread.joinable())
+            thread.join();
+    }
+
+    if (failure)
+        std::rethrow_exception(failure);
+}
+
+bool _bsa_extraction_int::isComplete() const {
+    return complete;
+}
+
+void _bsa_extraction_int::cancel() {
+    cancelled = true;
+}
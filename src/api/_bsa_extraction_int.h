@@ -0,0 +1,64 @@
+/*  libbsa
+
+A library for reading and writing BSA files.
+
+Copyright (C) 2012-2013    WrinklyNinja
+
+This file is part of libbsa.
+
+libbsa is free software: you can redistribute
+it and/or modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+libbsa is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with libbsa.  If not, see
+<http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef LIBBSA_BSA_EXTRACTION_INT_H
+#define LIBBSA_BSA_EXTRACTION_INT_H
+
+#include "genericbsa.h"
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// An extraction of a list of assets that runs in the background, passing
+// each asset to a handler as it's ready.
+struct _bsa_extraction_int {
+public:
+    _bsa_extraction_int(const libbsa::GenericBsa& bsa,
+                        const std::vector<std::string>& assetPaths,
+                        unsigned int threadCount,
+                        const libbsa::GenericBsa::AssetHandler& handler);
+
+    // Cancels the extraction and waits for it to stop.
+    ~_bsa_extraction_int();
+
+    // Waits for the extraction to finish, rethrowing any error that stopped
+    // it early.
+    void wait();
+    bool isComplete() const;
+
+    // Stops assets that haven't been started from being extracted.
+    void cancel();
+private:
+    std::atomic<bool> cancelled;
+    std::atomic<bool> complete;
+    std::exception_ptr failure;
+
+    std::thread thread;
+    std::mutex threadMutex;
+};
+
+#endif
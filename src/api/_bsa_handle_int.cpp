@@ -30,18 +30,20 @@
 using namespace libbsa;
 
 _bsa_handle_int::_bsa_handle_int(const boost::filesystem::path& path) :
-    extAssets(NULL),
-    extAssetsNum(0) {
-    if (tes3::BSA::IsBSA(path))
-        bsa = new tes3::BSA(path);
+    extractionThreads(1) {
+    //Open the file once, and keep it open for the lifetime of the handle.
+    ArchiveFile file(path);
+    if (tes3::BSA::IsBSA(file))
+        bsa = new tes3::BSA(path, std::move(file));
     else
-        bsa = new tes4::BSA(path);
+        bsa = new tes4::BSA(path, std::move(file));
 }
 
 _bsa_handle_int::~_bsa_handle_int() {
-    for (size_t i = 0; i < extAssetsNum; i++)
-        delete[] extAssets[i];
-    delete[] extAssets;
+    for (auto& assets : extAssets)
+        freeExtAssets(assets.second);
+
+    delete bsa;
 }
 
 GenericBsa * _bsa_handle_int::getBsa() const {
@@ -49,32 +51,98 @@ GenericBsa * _bsa_handle_int::getBsa() const {
 }
 
 char ** _bsa_handle_int::getExtAssets() const {
-    return extAssets;
+    std::lock_guard<std::mutex> lock(extAssetsMutex);
+
+    auto it = extAssets.find(std::this_thread::get_id());
+    return it == extAssets.end() ? NULL : it->second.paths;
 }
 
 size_t _bsa_handle_int::getExtAssetsNum() const {
-    return extAssetsNum;
+    std::lock_guard<std::mutex> lock(extAssetsMutex);
+
+    auto it = extAssets.find(std::this_thread::get_id());
+    return it == extAssets.end() ? 0 : it->second.num;
 }
 
 void _bsa_handle_int::setExtAssets(const std::vector<BsaAsset>& assets) {
-    extAssetsNum = assets.size();
-    extAssets = new char*[extAssetsNum];
+    char ** paths = new char*[assets.size()];
 
     size_t i = 0;
     for (const auto& asset : assets) {
-        extAssets[i] = ToNewCString(asset.path);
+        paths[i] = ToNewCString(asset.path);
         i++;
     }
+
+    setExtAssets(paths, assets.size());
+}
+
+void _bsa_handle_int::setExtAssets(const std::vector<std::string>& paths) {
+    char ** newPaths = new char*[paths.size()];
+
+    size_t i = 0;
+    for (const auto& path : paths) {
+        newPaths[i] = ToNewCString(path);
+        i++;
+    }
+
+    setExtAssets(newPaths, paths.size());
 }
 
 void _bsa_handle_int::freeExtAssets() {
-    if (extAssets != NULL) {
-        for (size_t i = 0; i < extAssetsNum; i++)
-            delete[] extAssets[i];
-        delete[] extAssets;
-        extAssets = NULL;
-        extAssetsNum = 0;
+    ExtAssets assets = {NULL, 0};
+    {
+        std::lock_guard<std::mutex> lock(extAssetsMutex);
+
+        auto it = extAssets.find(std::this_thread::get_id());
+        if (it == extAssets.end())
+            return;
+
+        assets = it->second;
+        extAssets.erase(it);
+    }
+
+    freeExtAssets(assets);
+}
+
+void _bsa_handle_int::addOwnedView(const std::shared_ptr<const uint8_t>& data) {
+    std::lock_guard<std::mutex> lock(ownedViewsMutex);
+    ownedViews.emplace(data.get(), data);
+}
+
+void _bsa_handle_int::releaseView(const uint8_t * data) {
+    std::lock_guard<std::mutex> lock(ownedViewsMutex);
+
+    auto it = ownedViews.find(data);
+    if (it != ownedViews.end())
+        ownedViews.erase(it);
+}
+
+unsigned int _bsa_handle_int::getExtractionThreads() const {
+    return extractionThreads;
+}
+
+void _bsa_handle_int::setExtractionThreads(unsigned int threads) {
+    extractionThreads = threads;
+}
+
+void _bsa_handle_int::setExtAssets(char ** paths, size_t num) {
+    ExtAssets oldAssets = {NULL, 0};
+    {
+        std::lock_guard<std::mutex> lock(extAssetsMutex);
+
+        ExtAssets& assets = extAssets[std::this_thread::get_id()];
+        oldAssets = assets;
+        assets.paths = paths;
+        assets.num = num;
     }
+
+    freeExtAssets(oldAssets);
+}
+
+void _bsa_handle_int::freeExtAssets(ExtAssets& assets) {
+    for (size_t i = 0; i < assets.num; i++)
+        delete[] assets.paths[i];
+    delete[] assets.paths;
 }
 
 // std::string to null-terminated char string converter.
@@ -26,26 +26,64 @@ along with libbsa.  If not, see
 
 #include "bsa_asset.h"
 #include "genericbsa.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
 
-//Class for generic BSA data manipulation functions.
+//Class for generic BSA data manipulation functions. Its functions can be
+//called from multiple threads at once.
 struct _bsa_handle_int {
 public:
     _bsa_handle_int(const boost::filesystem::path& path);
     ~_bsa_handle_int();
 
     libbsa::GenericBsa * getBsa() const;
+
+    // Each thread has its own external asset array, so that an array that
+    // one thread is using isn't freed by another thread's call. Arrays are
+    // freed when the same thread replaces or frees them, or the handle is
+    // destroyed.
     char ** getExtAssets() const;
     size_t getExtAssetsNum() const;
 
     void setExtAssets(const std::vector<libbsa::BsaAsset>& assets);
+    void setExtAssets(const std::vector<std::string>& paths);
     void freeExtAssets();
+
+    // Asset views that point into the archive mapping don't need freeing,
+    // but the handle holds the buffers of those that had to be decompressed.
+    // Cached buffers can be viewed more than once, so each view holds its own
+    // reference.
+    void addOwnedView(const std::shared_ptr<const uint8_t>& data);
+    void releaseView(const uint8_t * data);
+
+    unsigned int getExtractionThreads() const;
+    void setExtractionThreads(unsigned int threads);
 private:
+    struct ExtAssets {
+        char ** paths;
+        size_t num;
+    };
+
     libbsa::GenericBsa * bsa;
 
-    //External data array pointers and sizes.
-    char ** extAssets;
-    size_t extAssetsNum;
+    //Number of threads bsa_extract_assets() uses, 0 for one per hardware thread.
+    std::atomic<unsigned int> extractionThreads;
+
+    //External data array pointers and sizes, for each thread that has one.
+    std::unordered_map<std::thread::id, ExtAssets> extAssets;
+    mutable std::mutex extAssetsMutex;
+
+    std::unordered_multimap<const uint8_t*, std::shared_ptr<const uint8_t>> ownedViews;
+    std::mutex ownedViewsMutex;
+
+    // Replaces the calling thread's external asset array.
+    void setExtAssets(char ** paths, size_t num);
+
+    static void freeExtAssets(ExtAssets& assets);
 
     // std::string to null-terminated uint8_t string converter.
     static char * ToNewCString(const std::string& str);
@@ -0,0 +1,229 @@
+/*  libbsa
+
+    A library for reading and writing BSA files.
+
+    Copyright (C) 2012-2013    WrinklyNinja
+
+    This file is part of libbsa.
+
+    libbsa is free software: you can redistribute
+    it and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation, either version 3 of
+    the License, or (at your option) any later version.
+
+    libbsa is distributed in the hope that it will
+    be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libbsa.  If not, see
+    <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "archive_file.h"
+#include "error.h"
+#include "libbsa/libbsa.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#ifdef _WIN32
+#   ifndef NOMINMAX
+#       define NOMINMAX
+#   endif
+#   include <windows.h>
+#else
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace libbsa {
+    ArchiveFile::ArchiveFile() :
+#ifdef _WIN32
+        handle(INVALID_HANDLE_VALUE),
+        mappingHandle(NULL),
+#else
+        descriptor(-1),
+#endif
+        size(0),
+        mapping(NULL) {}
+
+#ifdef _WIN32
+    ArchiveFile::ArchiveFile(const boost::filesystem::path& path) : ArchiveFile() {
+        handle = CreateFileW(path.wstring().c_str(),
+                             GENERIC_READ,
+                             FILE_SHARE_READ | FILE_SHARE_WRITE,
+                             NULL,
+                             OPEN_EXISTING,
+                             FILE_ATTRIBUTE_NORMAL,
+                             NULL);
+        if (handle == INVALID_HANDLE_VALUE) {
+            DWORD lastError = GetLastError();
+            if (lastError == ERROR_FILE_NOT_FOUND || lastError == ERROR_PATH_NOT_FOUND)
+                return;
+
+            throw error(LIBBSA_ERROR_FILESYSTEM_ERROR, "Could not open \"" + path.string() + "\".");
+        }
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(handle, &fileSize)) {
+            Close();
+            throw error(LIBBSA_ERROR_FILESYSTEM_ERROR, "Could not get the size of \"" + path.string() + "\".");
+        }
+        size = fileSize.QuadPart;
+
+        // Empty files can't be mapped. If mapping fails for any other reason
+        // (eg. a 32-bit process can't find enough address space), the file
+        // is read from instead.
+        if (size == 0 || size > SIZE_MAX)
+            return;
+
+        mappingHandle = CreateFileMappingW(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mappingHandle == NULL)
+            return;
+
+        mapping = static_cast<const uint8_t*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+        if (mapping == NULL) {
+            CloseHandle(mappingHandle);
+            mappingHandle = NULL;
+        }
+    }
+#else
+    ArchiveFile::ArchiveFile(const boost::filesystem::path& path) : ArchiveFile() {
+        do {
+            descriptor = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        } while (descriptor == -1 && errno == EINTR);
+
+        if (descriptor == -1) {
+            if (errno == ENOENT)
+                return;
+
+            throw error(LIBBSA_ERROR_FILESYSTEM_ERROR, "Could not open \"" + path.string() + "\": " + strerror(errno));
+        }
+
+        struct stat status;
+        if (fstat(descriptor, &status) != 0) {
+            int statError = errno;
+            Close();
+            throw error(LIBBSA_ERROR_FILESYSTEM_ERROR, "Could not get the size of \"" + path.string() + "\": " + strerror(statError));
+        }
+        size = status.st_size;
+
+        // Empty files can't be mapped. If mapping fails for any other reason
+        // (eg. a 32-bit process can't find enough address space), the file
+        // is read from instead.
+        if (size == 0 || size > SIZE_MAX)
+            return;
+
+        void * address = mmap(NULL, size, PROT_READ, MAP_SHARED, descriptor, 0);
+        if (address != MAP_FAILED)
+            mapping = static_cast<const uint8_t*>(address);
+    }
+#endif
+
+    ArchiveFile::ArchiveFile(ArchiveFile&& other) : ArchiveFile() {
+        *this = std::move(other);
+    }
+
+    ArchiveFile& ArchiveFile::operator=(ArchiveFile&& other) {
+        if (this != &other) {
+            Close();
+
+#ifdef _WIN32
+            swap(handle, other.handle);
+            swap(mappingHandle, other.mappingHandle);
+#else
+            swap(descriptor, other.descriptor);
+#endif
+            swap(size, other.size);
+            swap(mapping, other.mapping);
+        }
+
+        return *this;
+    }
+
+    ArchiveFile::~ArchiveFile() {
+        Close();
+    }
+
+    bool ArchiveFile::IsOpen() const {
+#ifdef _WIN32
+        return handle != INVALID_HANDLE_VALUE;
+#else
+        return descriptor != -1;
+#endif
+    }
+
+    uint64_t ArchiveFile::GetSize() const {
+        return size;
+    }
+
+    const uint8_t * ArchiveFile::GetMapping() const {
+        return mapping;
+    }
+
+    void ArchiveFile::Read(uint64_t offset, size_t count, uint8_t * data) const {
+        if (!IsOpen())
+            throw error(LIBBSA_ERROR_FILESYSTEM_ERROR, "The archive file is not open.");
+
+        // Reads can return fewer bytes than asked for, so keep reading until
+        // everything has been read or the end of the file is reached.
+        while (count > 0) {
+#ifdef _WIN32
+            OVERLAPPED overlapped = {0};
+            overlapped.Offset = DWORD(offset);
+            overlapped.OffsetHigh = DWORD(offset >> 32);
+
+            DWORD bytesRead = 0;
+            DWORD toRead = DWORD(min(count, size_t(MAXDWORD)));
+            if (!ReadFile(handle, data, toRead, &bytesRead, &overlapped) && GetLastError() != ERROR_HANDLE_EOF)
+                throw error(LIBBSA_ERROR_FILESYSTEM_ERROR, "Could not read from the archive file.");
+#else
+            ssize_t bytesRead = pread(descriptor, data, count, offset);
+            if (bytesRead == -1) {
+                if (errno == EINTR)
+                    continue;
+
+                throw error(LIBBSA_ERROR_FILESYSTEM_ERROR, string("Could not read from the archive file: ") + strerror(errno));
+            }
+#endif
+            if (bytesRead == 0)
+                throw error(LIBBSA_ERROR_FILESYSTEM_ERROR, "Unexpected end of the archive file.");
+
+            data += bytesRead;
+            offset += bytesRead;
+            count -= bytesRead;
+        }
+    }
+
+    void ArchiveFile::Close() {
+#ifdef _WIN32
+        if (mapping != NULL)
+            UnmapViewOfFile(mapping);
+        if (mappingHandle != NULL)
+            CloseHandle(mappingHandle);
+        if (handle != INVALID_HANDLE_VALUE)
+            CloseHandle(handle);
+
+        handle = INVALID_HANDLE_VALUE;
+        mappingHandle = NULL;
+#else
+        if (mapping != NULL)
+            munmap(const_cast<uint8_t*>(mapping), size);
+        if (descriptor != -1)
+            close(descriptor);
+
+        descriptor = -1;
+#endif
+        size = 0;
+        mapping = NULL;
+    }
+}
@@ -0,0 +1,77 @@
+/*  libbsa
+
+    A library for reading and writing BSA files.
+
+    Copyright (C) 2012-2013    WrinklyNinja
+
+    This file is part of libbsa.
+
+    libbsa is free software: you can redistribute
+    it and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation, either version 3 of
+    the License, or (at your option) any later version.
+
+    libbsa is distributed in the hope that it will
+    be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libbsa.  If not, see
+    <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef __LIBBSA_ARCHIVE_FILE_H__
+#define __LIBBSA_ARCHIVE_FILE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <boost/filesystem/path.hpp>
+
+namespace libbsa {
+    // An archive file that is opened once and kept open, so that reads don't
+    // need to open the file again or resolve its path. Reads are positional,
+    // so they can be made from multiple threads at once. Where possible, the
+    // file is also memory-mapped.
+    class ArchiveFile {
+    public:
+        // Creates an ArchiveFile that isn't open.
+        ArchiveFile();
+
+        // Opens the file at the given path. If there is no file at the path,
+        // the ArchiveFile isn't open.
+        explicit ArchiveFile(const boost::filesystem::path& path);
+
+        ArchiveFile(ArchiveFile&& other);
+        ArchiveFile& operator=(ArchiveFile&& other);
+        ~ArchiveFile();
+
+        bool IsOpen() const;
+        uint64_t GetSize() const;
+
+        // Gets a pointer to the whole file mapped into memory, or NULL if the
+        // file couldn't be mapped.
+        const uint8_t * GetMapping() const;
+
+        // Reads count bytes of the file, starting at offset, into data.
+        void Read(uint64_t offset, size_t count, uint8_t * data) const;
+    private:
+        ArchiveFile(const ArchiveFile&) = delete;
+        ArchiveFile& operator=(const ArchiveFile&) = delete;
+
+        void Close();
+
+#ifdef _WIN32
+        void * handle;
+        void * mappingHandle;
+#else
+        int descriptor;
+#endif
+        uint64_t size;
+        const uint8_t * mapping;
+    };
+}
+
+#endif
@@ -0,0 +1,110 @@
+/*  libbsa
+
+    A library for reading and writing BSA files.
+
+    Copyright (C) 2012-2013    WrinklyNinja
+
+    This file is part of libbsa.
+
+    libbsa is free software: you can redistribute
+    it and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation, either version 3 of
+    the License, or (at your option) any later version.
+
+    libbsa is distributed in the hope that it will
+    be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libbsa.  If not, see
+    <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "asset_cache.h"
+
+using namespace std;
+
+namespace libbsa {
+    AssetCache::AssetCache() :
+        capacity(0),
+        size(0),
+        hits(0),
+        misses(0) {}
+
+    void AssetCache::SetCapacity(size_t newCapacity) {
+        lock_guard<mutex> lock(entriesMutex);
+
+        capacity = newCapacity;
+        Trim();
+    }
+
+    bool AssetCache::IsEnabled() const {
+        lock_guard<mutex> lock(entriesMutex);
+        return capacity > 0;
+    }
+
+    bool AssetCache::Get(uint64_t key, Data& data) {
+        lock_guard<mutex> lock(entriesMutex);
+
+        if (capacity == 0)
+            return false;
+
+        auto it = index.find(key);
+        if (it == index.end()) {
+            ++misses;
+            return false;
+        }
+
+        ++hits;
+        entries.splice(entries.begin(), entries, it->second);
+        data = it->second->second;
+
+        return true;
+    }
+
+    void AssetCache::Put(uint64_t key, const Data& data) {
+        lock_guard<mutex> lock(entriesMutex);
+
+        if (data.size > capacity)
+            return;
+
+        // Another thread may have cached the same data since this thread's
+        // lookup missed.
+        auto it = index.find(key);
+        if (it != index.end()) {
+            entries.splice(entries.begin(), entries, it->second);
+            return;
+        }
+
+        entries.emplace_front(key, data);
+        index.emplace(key, entries.begin());
+        size += data.size;
+
+        Trim();
+    }
+
+    uint64_t AssetCache::GetHits() const {
+        lock_guard<mutex> lock(entriesMutex);
+        return hits;
+    }
+
+    uint64_t AssetCache::GetMisses() const {
+        lock_guard<mutex> lock(entriesMutex);
+        return misses;
+    }
+
+    size_t AssetCache::GetSize() const {
+        lock_guard<mutex> lock(entriesMutex);
+        return size;
+    }
+
+    void AssetCache::Trim() {
+        while (size > capacity) {
+            size -= entries.back().second.size;
+            index.erase(entries.back().first);
+            entries.pop_back();
+        }
+    }
+}
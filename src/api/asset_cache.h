@@ -0,0 +1,93 @@
+/*  libbsa
+
+    A library for reading and writing BSA files.
+
+    Copyright (C) 2012-2013    WrinklyNinja
+
+    This file is part of libbsa.
+
+    libbsa is free software: you can redistribute
+    it and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation, either version 3 of
+    the License, or (at your option) any later version.
+
+    libbsa is distributed in the hope that it will
+    be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libbsa.  If not, see
+    <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef __LIBBSA_ASSET_CACHE_H__
+#define __LIBBSA_ASSET_CACHE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace libbsa {
+    // A least-recently-used cache of uncompressed asset data, holding at most
+    // a given number of bytes. Entries are keyed by the offset of the asset's
+    // stored data, which is unique within an archive. Cached data is shared,
+    // so data that is evicted stays valid for as long as something else
+    // holds it. Its functions can be called from multiple threads at once.
+    class AssetCache {
+    public:
+        struct Data {
+            Data() : size(0) {}
+
+            std::shared_ptr<const uint8_t> bytes;
+            size_t size;
+        };
+
+        AssetCache();
+
+        // Sets the maximum total size of the cached data, evicting the least
+        // recently used entries until they fit. A capacity of 0 disables the
+        // cache.
+        void SetCapacity(size_t capacity);
+        bool IsEnabled() const;
+
+        // Outputs the cached data for the given key, returning false if it
+        // isn't cached. Lookups made while the cache is enabled are counted as
+        // hits or misses.
+        bool Get(uint64_t key, Data& data);
+
+        // Caches the data for the given key, unless it's bigger than the
+        // capacity.
+        void Put(uint64_t key, const Data& data);
+
+        uint64_t GetHits() const;
+        uint64_t GetMisses() const;
+
+        // Gets the total size of the cached data.
+        size_t GetSize() const;
+    private:
+        // Entries are ordered from most to least recently used.
+        typedef std::list<std::pair<uint64_t, Data>> EntryList;
+
+        EntryList entries;
+        std::unordered_map<uint64_t, EntryList::iterator> index;
+
+        size_t capacity;
+        size_t size;
+        uint64_t hits;
+        uint64_t misses;
+
+        mutable std::mutex entriesMutex;
+
+        // Evicts the least recently used entries until the size fits the
+        // capacity. The mutex must be held.
+        void Trim();
+    };
+}
+
+#endif
@@ -0,0 +1,57 @@
+/*  libbsa
+
+    A library for reading and writing BSA files.
+
+    Copyright (C) 2012-2013    WrinklyNinja
+
+    This file is part of libbsa.
+
+    libbsa is free software: you can redistribute
+    it and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation, either version 3 of
+    the License, or (at your option) any later version.
+
+    libbsa is distributed in the hope that it will
+    be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libbsa.  If not, see
+    <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __LIBBSA_ASSET_PATH_H__
+#define __LIBBSA_ASSET_PATH_H__
+
+#include <stddef.h>
+#include <string>
+
+namespace libbsa {
+    // Normalises one character of an asset path: ASCII letters are
+    // lowercased and forward slashes become backslashes. Everything that
+    // compares asset paths uses this, so that they all agree.
+    inline char NormaliseAssetPathChar(char c) {
+        // Branchless, so that loops over it can be vectorised.
+        unsigned char u = c;
+        u += (unsigned char)((unsigned)(u - 'A') < 26u) << 5;
+        u += (unsigned char)(u == '/') * ('\\' - '/');
+        return u;
+    }
+
+    // Writes the normalised form of the given path to out, reusing its
+    // storage. A leading separator is removed.
+    inline void NormaliseAssetPath(const char * path, size_t length, std::string& out) {
+        if (length > 0 && (path[0] == '\\' || path[0] == '/')) {
+            path++;
+            length--;
+        }
+
+        out.resize(length);
+        char * data = &out[0];
+        for (size_t i = 0; i < length; ++i)
+            data[i] = NormaliseAssetPathChar(path[i]);
+    }
+}
+
+#endif
@@ -0,0 +1,317 @@
+/*  libbsa
+
+    A library for reading and writing BSA files.
+
+    Copyright (C) 2012-2013    WrinklyNinja
+
+    This file is part of libbsa.
+
+    libbsa is free software: you can redistribute
+    it and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation, either version 3 of
+    the License, or (at your option) any later version.
+
+    libbsa is distributed in the hope that it will
+    be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libbsa.  If not, see
+    <http://www.gnu.org/licenses/>.
+*/
+
+#include "asset_table.h"
+#include "asset_path.h"
+#include <cstring>
+
+using namespace std;
+
+namespace libbsa {
+    size_t AssetTable::size() const {
+        return records.size();
+    }
+
+    bool AssetTable::empty() const {
+        return records.empty();
+    }
+
+    void AssetTable::clear() {
+        pool.clear();
+        folders.clear();
+        records.clear();
+        hashes.clear();
+        folderIndices.clear();
+    }
+
+    void AssetTable::swap(AssetTable& other) {
+        pool.swap(other.pool);
+        folders.swap(other.folders);
+        records.swap(other.records);
+        hashes.swap(other.hashes);
+        folderIndices.swap(other.folderIndices);
+    }
+
+    void AssetTable::reserve(size_t assetCount, size_t namesLength) {
+        // Each name also has a null terminator.
+        pool.reserve(namesLength + assetCount);
+        records.reserve(assetCount);
+        hashes.reserve(assetCount);
+    }
+
+    uint32_t AssetTable::AddFolder(const std::string& name) {
+        auto result = folderIndices.emplace(name, folders.size());
+        if (result.second) {
+            Folder folder;
+            folder.name = AddName(name);
+            folder.length = name.length();
+            folders.push_back(folder);
+        }
+
+        return result.first->second;
+    }
+
+    void AssetTable::AddAsset(uint32_t folder,
+                              const std::string& fileName,
+                              uint64_t hash,
+                              uint32_t size,
+                              uint32_t offset) {
+        Record record;
+        record.folder = folder;
+        record.name = AddName(fileName);
+        record.size = size;
+        record.offset = offset;
+
+        records.push_back(record);
+        hashes.push_back(hash);
+    }
+
+    void AssetTable::AddAsset(const std::string& path,
+                              uint64_t hash,
+                              uint32_t size,
+                              uint32_t offset) {
+        // A leading separator is kept as part of the file name, so that the
+        // path is rebuilt exactly.
+        size_t pos = path.rfind('\\');
+        if (pos == string::npos || pos == 0)
+            AddAsset(AddFolder(""), path, hash, size, offset);
+        else
+            AddAsset(AddFolder(path.substr(0, pos)), path.substr(pos + 1), hash, size, offset);
+    }
+
+    BsaAsset AssetTable::operator[](size_t index) const {
+        BsaAsset asset;
+        asset.path = GetPath(index);
+        asset.hash = hashes[index];
+        asset.size = records[index].size;
+        asset.offset = records[index].offset;
+
+        return asset;
+    }
+
+    std::vector<BsaAsset> AssetTable::ToVector() const {
+        vector<BsaAsset> assets;
+        assets.reserve(records.size());
+        for (size_t i = 0; i < records.size(); ++i)
+            assets.push_back((*this)[i]);
+
+        return assets;
+    }
+
+    std::string AssetTable::GetPath(size_t index) const {
+        const Folder& folder = folders[records[index].folder];
+        const char * fileName = pool.data() + records[index].name;
+
+        if (folder.length == 0)
+            return fileName;
+
+        string path;
+        path.reserve(folder.length + 1 + strlen(fileName));
+        path.append(pool.data() + folder.name, folder.length);
+        path += '\\';
+        path += fileName;
+
+        return path;
+    }
+
+    std::string AssetTable::GetNormalisedPath(size_t index) const {
+        string path;
+        PathReader reader(*this, index);
+        unsigned char c;
+        while (reader.Next(c))
+            path += c;
+
+        return path;
+    }
+
+    int AssetTable::CompareNormalisedPath(size_t index, const std::string& normalisedPath) const {
+        return CompareNormalisedPath(index, normalisedPath.data(), normalisedPath.length());
+    }
+
+    int AssetTable::CompareNormalisedPath(size_t index, const char * normalisedPath, size_t length) const {
+        PathReader reader(*this, index);
+        unsigned char c;
+        for (size_t i = 0; i < length; ++i) {
+            if (!reader.Next(c))
+                return -1;
+
+            unsigned char other = normalisedPath[i];
+            if (c != other)
+                return c < other ? -1 : 1;
+        }
+
+        return reader.Next(c) ? 1 : 0;
+    }
+
+    int AssetTable::CompareNormalisedPaths(size_t first, size_t second) const {
+        PathReader firstReader(*this, first);
+        PathReader secondReader(*this, second);
+        unsigned char firstChar;
+        unsigned char secondChar;
+        while (true) {
+            bool firstMore = firstReader.Next(firstChar);
+            bool secondMore = secondReader.Next(secondChar);
+
+            if (!firstMore || !secondMore)
+                return firstMore ? 1 : (secondMore ? -1 : 0);
+
+            if (firstChar != secondChar)
+                return firstChar < secondChar ? -1 : 1;
+        }
+    }
+
+    uint32_t AssetTable::GetFolder(size_t index) const {
+        return records[index].folder;
+    }
+
+    size_t AssetTable::GetFolderCount() const {
+        return folders.size();
+    }
+
+    std::string AssetTable::GetFolderName(uint32_t folder) const {
+        return string(pool.data() + folders[folder].name, folders[folder].length);
+    }
+
+    bool AssetTable::HasNestedName(size_t index) const {
+        return strpbrk(pool.data() + records[index].name, "\\/") != NULL;
+    }
+
+    void AssetTable::Write(std::ostream& out) const {
+        WrittenHeader header;
+        header.folderCount = folders.size();
+        header.recordCount = records.size();
+        header.poolSize = pool.size();
+
+        out.write(reinterpret_cast<const char*>(&header), sizeof(WrittenHeader));
+        out.write(reinterpret_cast<const char*>(folders.data()), sizeof(Folder) * folders.size());
+        out.write(reinterpret_cast<const char*>(records.data()), sizeof(Record) * records.size());
+        out.write(reinterpret_cast<const char*>(hashes.data()), sizeof(uint64_t) * hashes.size());
+        out.write(pool.data(), pool.size());
+
+        // Everything before the pool is a multiple of 8 bytes, so pad the
+        // pool so that anything written after the table is aligned.
+        const char padding[8] = {0};
+        out.write(padding, (8 - pool.size() % 8) % 8);
+    }
+
+    size_t AssetTable::GetWrittenSize() const {
+        size_t size = sizeof(WrittenHeader)
+            + sizeof(Folder) * folders.size()
+            + (sizeof(Record) + sizeof(uint64_t)) * records.size()
+            + pool.size();
+
+        return (size + 7) / 8 * 8;
+    }
+
+    bool AssetTable::Read(const uint8_t * data, size_t size) {
+        if (size < sizeof(WrittenHeader))
+            return false;
+
+        WrittenHeader header;
+        memcpy(&header, data, sizeof(WrittenHeader));
+
+        const uint64_t arraysSize = sizeof(Folder) * uint64_t(header.folderCount)
+            + (sizeof(Record) + sizeof(uint64_t)) * uint64_t(header.recordCount);
+        if (header.poolSize > UINT32_MAX || arraysSize + header.poolSize > size - sizeof(WrittenHeader))
+            return false;
+
+        AssetTable table;
+        const uint8_t * pos = data + sizeof(WrittenHeader);
+        table.folders.resize(header.folderCount);
+        memcpy(table.folders.data(), pos, sizeof(Folder) * header.folderCount);
+        pos += sizeof(Folder) * header.folderCount;
+        table.records.resize(header.recordCount);
+        memcpy(table.records.data(), pos, sizeof(Record) * header.recordCount);
+        pos += sizeof(Record) * header.recordCount;
+        table.hashes.resize(header.recordCount);
+        memcpy(table.hashes.data(), pos, sizeof(uint64_t) * header.recordCount);
+        pos += sizeof(uint64_t) * header.recordCount;
+        table.pool.assign(reinterpret_cast<const char*>(pos), header.poolSize);
+
+        // Make sure that every name is inside the pool and null-terminated.
+        if (!table.pool.empty() && table.pool.back() != '\0')
+            return false;
+
+        table.folderIndices.reserve(table.folders.size());
+        for (uint32_t i = 0; i < table.folders.size(); ++i) {
+            const Folder& folder = table.folders[i];
+            if (uint64_t(folder.name) + folder.length >= table.pool.size() || table.pool[folder.name + folder.length] != '\0')
+                return false;
+
+            table.folderIndices.emplace(table.GetFolderName(i), i);
+        }
+
+        for (const auto& record : table.records) {
+            if (record.folder >= table.folders.size() || record.name >= table.pool.size())
+                return false;
+        }
+
+        swap(table);
+
+        return true;
+    }
+
+    uint32_t AssetTable::AddName(const std::string& name) {
+        uint32_t position = pool.length();
+        pool.append(name.c_str(), name.length() + 1);
+
+        return position;
+    }
+
+    AssetTable::PathReader::PathReader(const AssetTable& table, size_t index) :
+        piece(0),
+        pos(0),
+        atStart(true) {
+        const Folder& folder = table.folders[table.records[index].folder];
+
+        pieces[0] = table.pool.data() + folder.name;
+        lengths[0] = folder.length;
+        pieces[1] = "\\";
+        lengths[1] = folder.length == 0 ? 0 : 1;
+        pieces[2] = table.pool.data() + table.records[index].name;
+        lengths[2] = strlen(pieces[2]);
+    }
+
+    bool AssetTable::PathReader::Next(unsigned char& c) {
+        while (piece < 3) {
+            if (pos == lengths[piece]) {
+                piece++;
+                pos = 0;
+                continue;
+            }
+
+            c = NormaliseAssetPathChar(pieces[piece][pos++]);
+
+            // Normalisation removes a leading separator.
+            if (atStart) {
+                atStart = false;
+                if (c == '\\')
+                    continue;
+            }
+
+            return true;
+        }
+
+        return false;
+    }
+}
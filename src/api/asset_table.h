@@ -0,0 +1,152 @@
+/*  libbsa
+
+    A library for reading and writing BSA files.
+
+    Copyright (C) 2012-2013    WrinklyNinja
+
+    This file is part of libbsa.
+
+    libbsa is free software: you can redistribute
+    it and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation, either version 3 of
+    the License, or (at your option) any later version.
+
+    libbsa is distributed in the hope that it will
+    be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libbsa.  If not, see
+    <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __LIBBSA_ASSET_TABLE_H__
+#define __LIBBSA_ASSET_TABLE_H__
+
+#include "bsa_asset.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace libbsa {
+    // Compact storage for an archive's asset metadata. Folder and file names
+    // are stored once each, in a single pool, and each asset is a fixed-size
+    // record referring to them, so loading an archive makes a handful of
+    // allocations instead of one per asset. BsaAssets are built on demand.
+    class AssetTable {
+    public:
+        size_t size() const;
+        bool empty() const;
+
+        void clear();
+        void swap(AssetTable& other);
+
+        // Reserves space for the given number of assets, with the given total
+        // length of folder and file names.
+        void reserve(size_t assetCount, size_t namesLength);
+
+        // Adds a folder, returning its index. Folders with the same name
+        // share an index.
+        uint32_t AddFolder(const std::string& name);
+
+        // Adds an asset in the given folder.
+        void AddAsset(uint32_t folder,
+                      const std::string& fileName,
+                      uint64_t hash,
+                      uint32_t size,
+                      uint32_t offset);
+
+        // Adds an asset, adding its folder if necessary.
+        void AddAsset(const std::string& path,
+                      uint64_t hash,
+                      uint32_t size,
+                      uint32_t offset);
+
+        BsaAsset operator[](size_t index) const;
+        std::vector<BsaAsset> ToVector() const;
+
+        std::string GetPath(size_t index) const;
+
+        // Gets the asset's path normalised as GenericBsa::NormaliseAssetPath
+        // would.
+        std::string GetNormalisedPath(size_t index) const;
+
+        // Compares the asset's normalised path with the given normalised
+        // path, without building either, like std::string::compare.
+        int CompareNormalisedPath(size_t index, const std::string& normalisedPath) const;
+        int CompareNormalisedPath(size_t index, const char * normalisedPath, size_t length) const;
+        int CompareNormalisedPaths(size_t first, size_t second) const;
+
+        uint32_t GetFolder(size_t index) const;
+        size_t GetFolderCount() const;
+        std::string GetFolderName(uint32_t folder) const;
+
+        // Checks if the asset's file name contains a path separator, so that
+        // its normalised path is in a subfolder of its folder.
+        bool HasNestedName(size_t index) const;
+
+        // Writes the table's arrays out as they're stored in memory, so that
+        // they can be read back with a few copies. The size written is a
+        // multiple of 8 bytes.
+        void Write(std::ostream& out) const;
+        size_t GetWrittenSize() const;
+
+        // Replaces the table's contents with a table that was written to the
+        // given data, returning false if the data isn't a valid table.
+        bool Read(const uint8_t * data, size_t size);
+    private:
+        // Asset records are 16 bytes. The hashes are stored separately so
+        // that records stay small and lookups that only need hashes don't
+        // touch the rest.
+        struct Record {
+            uint32_t folder;
+            uint32_t name;      // Position of the file name in the pool.
+            uint32_t size;
+            uint32_t offset;
+        };
+
+        struct Folder {
+            uint32_t name;      // Position of the folder name in the pool.
+            uint32_t length;
+        };
+
+        // Reads an asset's normalised path a character at a time.
+        class PathReader {
+        public:
+            PathReader(const AssetTable& table, size_t index);
+
+            // Gets the next character, returning false at the end.
+            bool Next(unsigned char& c);
+        private:
+            const char * pieces[3];
+            size_t lengths[3];
+            size_t piece;
+            size_t pos;
+            bool atStart;
+        };
+
+        // The start of a written table.
+        struct WrittenHeader {
+            uint32_t folderCount;
+            uint32_t recordCount;
+            uint64_t poolSize;
+        };
+
+        // Null-terminated names, one after another.
+        std::string pool;
+        std::vector<Folder> folders;
+        std::vector<Record> records;
+        std::vector<uint64_t> hashes;
+
+        // Maps folder names to their index.
+        std::unordered_map<std::string, uint32_t> folderIndices;
+
+        uint32_t AddName(const std::string& name);
+    };
+}
+
+#endif
@@ -22,51 +22,309 @@
 */
 
 #include "genericbsa.h"
+#include "asset_path.h"
 #include "error.h"
 #include "libbsa/libbsa.h"
 
-#include <boost/algorithm/string.hpp>
-#include <boost/crc.hpp>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+
 #include <boost/filesystem.hpp>
-#include <boost/locale.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <zlib.h>
 
 namespace fs = boost::filesystem;
 
 using namespace std;
 
 namespace libbsa {
-    GenericBsa::GenericBsa(const boost::filesystem::path& path) : filePath(path) {}
+    // The code points of the characters that Windows-1252 encodes as 0x80
+    // to 0x9F, or 0 for bytes that it leaves undefined. Every other byte
+    // encodes the code point with the same value.
+    static const uint16_t Windows1252Table[32] = {
+        0x20AC, 0, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021,
+        0x02C6, 0x2030, 0x0160, 0x2039, 0x0152, 0, 0x017D, 0,
+        0, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014,
+        0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0, 0x017E, 0x0178
+    };
+
+    const char GenericBsa::IndexCacheMagic[8] = {'L', 'I', 'B', 'B', 'S', 'A', 'I', 'X'};
+    boost::filesystem::path GenericBsa::indexCacheDirectory;
+    std::mutex GenericBsa::indexCacheMutex;
+
+    GenericBsa::GenericBsa(const boost::filesystem::path& path, ArchiveFile&& archiveFile) :
+        filePath(path),
+        file(std::move(archiveFile)),
+        assetsLoaded(true),
+        recordsSize(0) {}
 
     bool GenericBsa::HasAsset(const std::string& assetPath) const {
-        std::string normalisedAssetPath = NormaliseAssetPath(assetPath);
+        // Lookups normalise into a per-thread buffer, so don't allocate
+        // once it's big enough.
+        static thread_local string normalisedPath;
+        libbsa::NormaliseAssetPath(assetPath.data(), assetPath.length(), normalisedPath);
 
-        return std::any_of(begin(assets), end(assets), [&](const BsaAsset& asset) {
-            return asset.path == normalisedAssetPath;
-        });
+        return FindAsset(normalisedPath, NULL);
+    }
+
+    void GenericBsa::HasAssets(const char * const * assetPaths,
+                               size_t count,
+                               bool * results) const {
+        string normalisedPath;
+        if (!assetsLoaded) {
+            // The archive's own index can be searched by hash without
+            // loading its assets, which is cheaper than loading them.
+            for (size_t i = 0; i < count; ++i) {
+                libbsa::NormaliseAssetPath(assetPaths[i], strlen(assetPaths[i]), normalisedPath);
+                results[i] = FindAsset(normalisedPath, NULL);
+            }
+            return;
+        }
+
+        // Normalise the paths into one buffer, then sort them, so that they
+        // can be found in a single pass through the sorted assets.
+        string normalisedPaths;
+        vector<size_t> offsets;
+        offsets.reserve(count + 1);
+        offsets.push_back(0);
+        for (size_t i = 0; i < count; ++i) {
+            libbsa::NormaliseAssetPath(assetPaths[i], strlen(assetPaths[i]), normalisedPath);
+            normalisedPaths += normalisedPath;
+            offsets.push_back(normalisedPaths.length());
+        }
+
+        auto compareQueries = [&](size_t first, size_t second) {
+            size_t firstLength = offsets[first + 1] - offsets[first];
+            size_t secondLength = offsets[second + 1] - offsets[second];
+            int result = memcmp(normalisedPaths.data() + offsets[first],
+                                normalisedPaths.data() + offsets[second],
+                                min(firstLength, secondLength));
+            return result < 0 || (result == 0 && firstLength < secondLength);
+        };
+
+        vector<size_t> order(count);
+        for (size_t i = 0; i < count; ++i)
+            order[i] = i;
+        sort(begin(order), end(order), compareQueries);
+
+        // Walk through the sorted assets and sorted paths together. Each
+        // path is searched for by stepping forwards from the previous one in
+        // doubling steps, then binary searching the last step, so that this
+        // costs about as much as a merge when there are many paths, and as
+        // much as separate searches when there are few.
+        auto it = begin(sortedAssetIndex);
+        const auto last = end(sortedAssetIndex);
+        for (size_t query : order) {
+            const char * path = normalisedPaths.data() + offsets[query];
+            size_t length = offsets[query + 1] - offsets[query];
+            auto isBefore = [&](uint32_t index, size_t) {
+                return assets.CompareNormalisedPath(index, path, length) < 0;
+            };
+
+            ptrdiff_t step = 1;
+            while (last - it > step && isBefore(it[step], query)) {
+                it += step + 1;
+                step *= 2;
+            }
+            auto stepEnd = last - it > step ? it + step + 1 : last;
+
+            it = lower_bound(it, stepEnd, query, isBefore);
+            results[query] = it != last && assets.CompareNormalisedPath(*it, path, length) == 0;
+        }
     }
 
     BsaAsset GenericBsa::GetAsset(const std::string& assetPath) const {
-        std::string normalisedAssetPath = NormaliseAssetPath(assetPath);
+        static thread_local string normalisedPath;
+        libbsa::NormaliseAssetPath(assetPath.data(), assetPath.length(), normalisedPath);
+
+        BsaAsset asset;
+        FindAsset(normalisedPath, &asset);
+
+        return asset;
+    }
+
+    std::vector<std::string> GenericBsa::GetNormalisedAssetPaths() const {
+        RequireAssets();
 
-        auto it = find_if(begin(assets), end(assets), [&](const BsaAsset& asset) {
-            return asset.path == normalisedAssetPath;
+        vector<string> paths;
+        paths.reserve(sortedAssetIndex.size());
+        for (const auto index : sortedAssetIndex)
+            paths.push_back(assets.GetNormalisedPath(index));
+
+        return paths;
+    }
+
+    std::vector<std::string> GenericBsa::GetFolderContents(const std::string& folderPath) const {
+        RequireAssets();
+
+        string normalisedPath = NormaliseAssetPath(folderPath);
+        if (!normalisedPath.empty() && normalisedPath.back() == '\\')
+            normalisedPath.pop_back();
+
+        auto it = folderIndex.find(normalisedPath);
+        if (it == end(folderIndex))
+            throw error(LIBBSA_ERROR_INVALID_ARGS, "Folder not found");
+
+        vector<string> contents;
+        contents.reserve(it->second.subfolders.size() + it->second.assetIndices.size());
+        for (const auto& subfolder : it->second.subfolders)
+            contents.push_back(folderIndex.at(subfolder).path + '\\');
+        for (const auto index : it->second.assetIndices)
+            contents.push_back(assets.GetPath(index));
+
+        return contents;
+    }
+
+    std::vector<BsaAsset> GenericBsa::GetMatchingAssets(const regex& regex,
+                                                        const std::string& pattern) const {
+        // std::regex is slow, so only try to match assets that could match,
+        // going by the literal text at the start of the pattern.
+        return GetMatchingAssets(GetLiteralPrefix(pattern), [&](const std::string&, const std::string& path) {
+            return regex_match(path, regex);
         });
+    }
 
-        if (it != end(assets))
-            return *it;
+    std::vector<BsaAsset> GenericBsa::GetMatchingAssets(const std::string& glob) const {
+        string normalisedGlob = NormaliseAssetPath(glob);
 
-        return BsaAsset();
+        return GetMatchingAssets(GetGlobLiteralPrefix(normalisedGlob), [&](const std::string& normalisedPath, const std::string&) {
+            return GlobMatch(normalisedGlob.c_str(), normalisedPath.c_str());
+        });
     }
 
-    std::vector<BsaAsset> GenericBsa::GetMatchingAssets(const regex& regex) const {
-        vector<BsaAsset> matchingAssets;
-        copy_if(begin(assets), end(assets), back_inserter(matchingAssets), [&](const BsaAsset& asset) {
-            return regex_match(asset.path, regex);
+    std::vector<BsaAsset> GenericBsa::GetMatchingAssets(const std::string& prefix,
+                                                        const std::function<bool(const std::string& normalisedPath, const std::string& path)>& predicate) const {
+        RequireAssets();
+
+        auto it = lower_bound(begin(sortedAssetIndex), end(sortedAssetIndex), prefix, [&](uint32_t index, const string& prefix) {
+            return assets.CompareNormalisedPath(index, prefix) < 0;
         });
 
+        vector<uint32_t> matchingIndices;
+        for (auto endIt = end(sortedAssetIndex); it != endIt; ++it) {
+            string normalisedPath = assets.GetNormalisedPath(*it);
+            if (normalisedPath.compare(0, prefix.length(), prefix) != 0)
+                break;
+
+            if (predicate(normalisedPath, assets.GetPath(*it)))
+                matchingIndices.push_back(*it);
+        }
+
+        // Return matches in the same order as a linear search would.
+        sort(begin(matchingIndices), end(matchingIndices));
+
+        vector<BsaAsset> matchingAssets;
+        matchingAssets.reserve(matchingIndices.size());
+        for (const auto index : matchingIndices)
+            matchingAssets.push_back(assets[index]);
+
         return matchingAssets;
     }
 
+    std::string GenericBsa::GetLiteralPrefix(const std::string& regex) {
+        // Alternation means that matches could start in different ways.
+        if (regex.find('|') != string::npos)
+            return "";
+
+        string prefix;
+        for (size_t i = 0; i < regex.length(); ++i) {
+            char c = regex[i];
+            if (c == '\\') {
+                // An escaped punctuation character is a literal.
+                if (i + 1 == regex.length() || !ispunct((unsigned char)regex[i + 1]))
+                    break;
+                c = regex[++i];
+            }
+            else if (strchr(".[]()*+?{}^$", c) != NULL)
+                break;
+
+            // Stop at a character that could be repeated or left out, and
+            // at non-ASCII characters, which may be lowercased differently.
+            if ((unsigned char)c >= 0x80)
+                break;
+            if (i + 1 < regex.length() && strchr("*+?{", regex[i + 1]) != NULL)
+                break;
+
+            prefix += c;
+        }
+
+        prefix = NormaliseAssetPath(prefix);
+
+        // Normalisation removes leading separators from paths but not from
+        // the prefix, so don't filter on them.
+        if (!prefix.empty() && prefix[0] == '\\')
+            return "";
+
+        return prefix;
+    }
+
+    std::string GenericBsa::GetGlobLiteralPrefix(const std::string& glob) {
+        return glob.substr(0, glob.find_first_of("*?"));
+    }
+
+    bool GenericBsa::GlobMatch(const char * glob, const char * path) {
+        // Matches iteratively, remembering only where the last '*' and the
+        // last '**' started, so that a mismatch backtracks to one of them
+        // rather than trying every combination of wildcard lengths. A '*'
+        // can't be extended past a separator, so matching then falls back to
+        // the last '**', and restarts the part of the glob after it.
+        const char * starGlob = NULL;
+        const char * starPath = NULL;
+        const char * doubleStarGlob = NULL;
+        const char * doubleStarPath = NULL;
+
+        while (*path != '\0') {
+            if (*glob == '*') {
+                if (glob[1] == '*') {
+                    glob += 2;
+                    doubleStarGlob = glob;
+                    doubleStarPath = path;
+                    starGlob = NULL;
+                }
+                else {
+                    ++glob;
+                    starGlob = glob;
+                    starPath = path;
+                }
+                continue;
+            }
+
+            if (*glob != '\0' && (*glob == '?' ? *path != '\\' : *glob == *path)) {
+                ++glob;
+                ++path;
+                continue;
+            }
+
+            // Let the last wildcard match one more character.
+            if (starGlob != NULL && *starPath != '\\') {
+                glob = starGlob;
+                path = ++starPath;
+            }
+            else if (doubleStarGlob != NULL) {
+                glob = doubleStarGlob;
+                path = ++doubleStarPath;
+                starGlob = NULL;
+            }
+            else
+                return false;
+        }
+
+        // Only wildcards can match the empty rest of the path.
+        while (*glob == '*')
+            ++glob;
+
+        return *glob == '\0';
+    }
+
     void GenericBsa::Extract(const std::string& assetPath,
                              const uint8_t ** const _data,
                              size_t * const _size) const {
@@ -75,23 +333,28 @@ namespace libbsa {
         if (data.path.empty())
             throw error(LIBBSA_ERROR_INVALID_ARGS, "Asset not found");
 
-        pair<uint8_t*, size_t> dataPair;
-        try {
-            //Read file data.
-            boost::filesystem::ifstream in(filePath, ios::binary);
-            in.exceptions(ios::failbit | ios::badbit | ios::eofbit);  //Causes ifstream::failure to be thrown if problem is encountered.
-
-            dataPair = ReadData(in, data);
+        if (!IsCacheable(data)) {
+            pair<uint8_t*, size_t> dataPair = ReadData(data);
 
             *_data = dataPair.first;
             *_size = dataPair.second;
+            return;
+        }
 
-            in.close();
+        //The caller owns the output, so copy it out of the cache.
+        AssetCache::Data cachedData = GetCachedData(data);
+        uint8_t * outBuffer;
+        try {
+            outBuffer = new uint8_t[cachedData.size];
         }
-        catch (ios_base::failure& e) {
-            delete[] dataPair.first;
-            throw error(LIBBSA_ERROR_FILESYSTEM_ERROR, e.what());
+        catch (bad_alloc& e) {
+            throw error(LIBBSA_ERROR_NO_MEM, e.what());
         }
+
+        memcpy(outBuffer, cachedData.bytes.get(), cachedData.size);
+
+        *_data = outBuffer;
+        *_size = cachedData.size;
     }
 
     void GenericBsa::Extract(const std::string& assetPath,
@@ -102,19 +365,409 @@ namespace libbsa {
         if (!overwrite && fs::exists(outFilePath))
             throw error(LIBBSA_ERROR_FILESYSTEM_ERROR, "The file \"" + outFilePath.string() + "\" already exists.");
 
+        //Get asset data.
+        BsaAsset asset = GetAsset(assetPath);
+        if (asset.path.empty())
+            throw error(LIBBSA_ERROR_INVALID_ARGS, "Asset not found");
+
+        vector<uint8_t> buffer;
+        const uint8_t * storedData = ReadBytes(asset.offset, GetStoredSize(asset), buffer);
+
+        WriteAsset(asset, storedData, outFilePath);
+    }
+
+    void GenericBsa::Extract(const std::string& assetPath,
+                             const ChunkHandler& handler) const {
+        //Get asset data.
+        BsaAsset asset = GetAsset(assetPath);
+        if (asset.path.empty())
+            throw error(LIBBSA_ERROR_INVALID_ARGS, "Asset not found");
+
+        vector<uint8_t> buffer;
+        const uint8_t * storedData = ReadBytes(asset.offset, GetStoredSize(asset), buffer);
+
+        StreamData(asset, storedData, handler);
+    }
+
+    void GenericBsa::Extract(const vector<BsaAsset>& assetsToExtract,
+                             const boost::filesystem::path& destRootPath,
+                             const bool overwrite,
+                             unsigned int threadCount) const {
+        // Extract assets in the order their data is stored, so that reads
+        // move forwards through the archive, and group assets that are stored
+        // next to (or near) each other into runs that are read all at once.
+        vector<const BsaAsset*> sortedAssets;
+        sortedAssets.reserve(assetsToExtract.size());
+        for (const auto& asset : assetsToExtract)
+            sortedAssets.push_back(&asset);
+
+        stable_sort(begin(sortedAssets), end(sortedAssets), [](const BsaAsset * first, const BsaAsset * second) {
+            return first->offset < second->offset;
+        });
+
+        const vector<ReadRun> runs = GetReadRuns(sortedAssets);
+
+        auto extractRun = [&](const ReadRun& run, vector<uint8_t>& buffer) {
+            // Check for existing files before reading anything.
+            for (size_t i = run.firstAsset; i < run.lastAsset; ++i) {
+                fs::path outFilePath = destRootPath / sortedAssets[i]->path;
+                if (!overwrite && fs::exists(outFilePath))
+                    throw error(LIBBSA_ERROR_FILESYSTEM_ERROR, "The file \"" + outFilePath.string() + "\" already exists.");
+            }
+
+            const uint8_t * runData = ReadBytes(run.offset, run.size, buffer);
+
+            for (size_t i = run.firstAsset; i < run.lastAsset; ++i) {
+                WriteAsset(*sortedAssets[i],
+                           runData + (sortedAssets[i]->offset - run.offset),
+                           destRootPath / sortedAssets[i]->path);
+            }
+        };
+
+        if (threadCount == 0)
+            threadCount = max(thread::hardware_concurrency(), 1u);
+        if (threadCount > runs.size())
+            threadCount = runs.size();
+
+        if (threadCount <= 1) {
+            vector<uint8_t> buffer;
+            for (const auto& run : runs) {
+                extractRun(run, buffer);
+            }
+            return;
+        }
+
+        // Each worker takes the next unextracted run until there are none
+        // left or one of them fails. Runs are handed out in offset order, so
+        // the archive is still read roughly sequentially. Reads go through
+        // the mapping or a per-worker buffer, and decompression state is
+        // per-call, so workers share nothing else.
+        atomic<size_t> nextRun(0);
+        atomic<bool> failed(false);
+        exception_ptr firstError;
+        mutex errorMutex;
+
+        auto worker = [&]() {
+            vector<uint8_t> buffer;
+            for (size_t i = nextRun++; i < runs.size() && !failed; i = nextRun++) {
+                try {
+                    extractRun(runs[i], buffer);
+                }
+                catch (...) {
+                    lock_guard<mutex> guard(errorMutex);
+                    if (!firstError)
+                        firstError = current_exception();
+                    failed = true;
+                }
+            }
+        };
+
+        // If a thread can't be started, carry on with those that were.
+        vector<thread> workers;
+        workers.reserve(threadCount - 1);
         try {
-            //Create parent directories.
-            fs::create_directories(outFilePath.parent_path());  //This creates any directories in the path that don't already exist.
+            for (unsigned int i = 1; i < threadCount; ++i)
+                workers.emplace_back(worker);
+        }
+        catch (system_error&) {}
+        worker();
+
+        for (auto& workerThread : workers)
+            workerThread.join();
+
+        if (firstError)
+            rethrow_exception(firstError);
+    }
+
+    void GenericBsa::Extract(const std::vector<std::string>& assetPaths,
+                             const AssetHandler& handler,
+                             unsigned int threadCount,
+                             const std::atomic<bool>& cancelled) const {
+        // Look up all the assets first, so that they can be read in the
+        // order their data is stored.
+        vector<BsaAsset> foundAssets;
+        vector<size_t> foundIndices;
+        foundAssets.reserve(assetPaths.size());
+        foundIndices.reserve(assetPaths.size());
+        for (size_t i = 0; i < assetPaths.size() && !cancelled; ++i) {
+            BsaAsset asset = GetAsset(assetPaths[i]);
+            if (asset.path.empty()) {
+                error e(LIBBSA_ERROR_INVALID_ARGS, "Asset not found");
+                handler(i, &e, NULL, 0);
+                continue;
+            }
+
+            foundAssets.push_back(asset);
+            foundIndices.push_back(i);
+        }
+
+        vector<const BsaAsset*> sortedAssets;
+        sortedAssets.reserve(foundAssets.size());
+        for (const auto& asset : foundAssets)
+            sortedAssets.push_back(&asset);
+
+        stable_sort(begin(sortedAssets), end(sortedAssets), [](const BsaAsset * first, const BsaAsset * second) {
+            return first->offset < second->offset;
+        });
 
+        const vector<ReadRun> runs = GetReadRuns(sortedAssets);
+
+        auto getIndex = [&](const BsaAsset * asset) {
+            return foundIndices[asset - foundAssets.data()];
+        };
+
+        if (threadCount == 0)
+            threadCount = max(thread::hardware_concurrency(), 1u);
+
+        // Runs that have been read wait in a queue for a worker. The reader
+        // stops when the queue is full, so that memory use stays bounded.
+        struct ReadJob {
+            const ReadRun * run;
             const uint8_t * data;
-            size_t dataSize;
-            Extract(assetPath, &data, &dataSize);
+            shared_ptr<vector<uint8_t>> buffer;
+        };
+
+        const size_t maxPending = 2 * threadCount;
+        deque<ReadJob> jobs;
+        bool readingDone = false;
+        atomic<bool> stopped(false);
+        mutex jobsMutex;
+        condition_variable jobsChanged;
+
+        auto worker = [&]() {
+            while (true) {
+                ReadJob job;
+                {
+                    unique_lock<mutex> lock(jobsMutex);
+                    jobsChanged.wait(lock, [&]() { return readingDone || !jobs.empty(); });
+                    if (jobs.empty())
+                        return;
+
+                    job = jobs.front();
+                    jobs.pop_front();
+                    jobsChanged.notify_all();
+                }
+
+                for (size_t i = job.run->firstAsset; i < job.run->lastAsset && !cancelled && !stopped; ++i) {
+                    const BsaAsset& asset = *sortedAssets[i];
+                    const uint8_t * storedData = job.data + (asset.offset - job.run->offset);
+
+                    unique_ptr<uint8_t[]> uncompressedData;
+                    const uint8_t * data = storedData;
+                    size_t size = GetStoredSize(asset);
+                    try {
+                        if (IsCompressed(asset)) {
+                            pair<uint8_t*, size_t> dataPair = UncompressData(asset, storedData, size);
+                            uncompressedData.reset(dataPair.first);
+                            data = dataPair.first;
+                            size = dataPair.second;
+                        }
+                    }
+                    catch (bad_alloc& e) {
+                        error noMem(LIBBSA_ERROR_NO_MEM, e.what());
+                        handler(getIndex(&asset), &noMem, NULL, 0);
+                        continue;
+                    }
+                    catch (error& e) {
+                        handler(getIndex(&asset), &e, NULL, 0);
+                        continue;
+                    }
+
+                    handler(getIndex(&asset), NULL, data, size);
+                }
+            }
+        };
+
+        // If reading fails outright, the workers are stopped and joined
+        // before the error is passed on, as they can't outlive this call.
+        auto stopWorkers = [&]() {
+            lock_guard<mutex> lock(jobsMutex);
+            readingDone = true;
+            jobsChanged.notify_all();
+        };
+
+        vector<thread> workers;
+        try {
+            for (unsigned int i = 0; i < threadCount; ++i)
+                workers.emplace_back(worker);
+
+            for (const auto& run : runs) {
+                if (cancelled)
+                    break;
+
+                ReadJob job;
+                job.run = &run;
+                job.buffer = make_shared<vector<uint8_t>>();
+                try {
+                    job.data = ReadBytes(run.offset, run.size, *job.buffer);
+                }
+                catch (bad_alloc& e) {
+                    error noMem(LIBBSA_ERROR_NO_MEM, e.what());
+                    for (size_t i = run.firstAsset; i < run.lastAsset; ++i)
+                        handler(getIndex(sortedAssets[i]), &noMem, NULL, 0);
+                    continue;
+                }
+                catch (error& e) {
+                    for (size_t i = run.firstAsset; i < run.lastAsset; ++i)
+                        handler(getIndex(sortedAssets[i]), &e, NULL, 0);
+                    continue;
+                }
+
+                unique_lock<mutex> lock(jobsMutex);
+                jobsChanged.wait(lock, [&]() { return jobs.size() < maxPending; });
+                jobs.push_back(job);
+                jobsChanged.notify_all();
+            }
+        }
+        catch (...) {
+            stopped = true;
+            stopWorkers();
+            for (auto& workerThread : workers)
+                workerThread.join();
+            throw;
+        }
+
+        stopWorkers();
+        for (auto& workerThread : workers)
+            workerThread.join();
+    }
+
+    std::shared_ptr<const uint8_t> GenericBsa::ExtractView(const std::string& assetPath,
+                                                           const uint8_t ** const data,
+                                                           size_t * const size) const {
+        BsaAsset asset = GetAsset(assetPath);
+        if (asset.path.empty())
+            throw error(LIBBSA_ERROR_INVALID_ARGS, "Asset not found");
+
+        if (file.GetMapping() != NULL && !IsCompressed(asset)) {
+            std::vector<uint8_t> unused;
+            *size = GetStoredSize(asset);
+            *data = ReadBytes(asset.offset, *size, unused);
+
+            return shared_ptr<const uint8_t>();
+        }
+
+        AssetCache::Data assetData;
+        if (IsCacheable(asset))
+            assetData = GetCachedData(asset);
+        else {
+            pair<uint8_t*, size_t> dataPair = ReadData(asset);
+            assetData.bytes.reset(dataPair.first, default_delete<uint8_t[]>());
+            assetData.size = dataPair.second;
+        }
+
+        *data = assetData.bytes.get();
+        *size = assetData.size;
+
+        return assetData.bytes;
+    }
+
+    uint32_t GenericBsa::CalcChecksum(const std::string& assetPath) const {
+        BsaAsset asset = GetAsset(assetPath);
+        if (asset.path.empty())
+            throw error(LIBBSA_ERROR_INVALID_ARGS, "Asset not found");
+
+        //zlib's crc32 is sliced, and uses PCLMULQDQ when built with zlib-ng.
+        uLong checksum = crc32(0, Z_NULL, 0);
+        auto process = [&checksum](const uint8_t * data, size_t size) {
+            checksum = crc32(checksum, data, size);
+        };
+
+        //If the asset cache is in use, go through it so that the asset is
+        //only decompressed once if it's also extracted. Otherwise stream the
+        //data, so that the uncompressed asset is never held in memory.
+        if (IsCacheable(asset)) {
+            AssetCache::Data data = GetCachedData(asset);
+            for (size_t pos = 0; pos < data.size; pos += ChunkSize)
+                process(data.bytes.get() + pos, min(ChunkSize, data.size - pos));
+        }
+        else {
+            vector<uint8_t> buffer;
+            const uint8_t * storedData = ReadBytes(asset.offset, GetStoredSize(asset), buffer);
+
+            StreamData(asset, storedData, process);
+        }
+
+        return checksum;
+    }
+
+    AssetCache& GenericBsa::GetAssetCache() const {
+        return assetCache;
+    }
+
+    std::pair<uint8_t*, size_t> GenericBsa::ReadData(const BsaAsset& data) const {
+        const uint32_t size = GetStoredSize(data);
+
+        vector<uint8_t> buffer;
+        const uint8_t * storedData = ReadBytes(data.offset, size, buffer);
+
+        if (IsCompressed(data))
+            return UncompressData(data, storedData, size);
+
+        uint8_t * outBuffer;
+        try {
+            outBuffer = new uint8_t[size];
+        }
+        catch (bad_alloc& e) {
+            throw error(LIBBSA_ERROR_NO_MEM, e.what());
+        }
+
+        memcpy(outBuffer, storedData, size);
+
+        return make_pair(outBuffer, size);
+    }
+
+    std::pair<uint8_t*, size_t> GenericBsa::UncompressData(const BsaAsset& data,
+                                                           const uint8_t *,
+                                                           size_t) const {
+        throw error(LIBBSA_ERROR_ZLIB_ERROR, "Uncompressing of \"" + data.path + "\" failed.");
+    }
+
+    void GenericBsa::UncompressData(const BsaAsset& data,
+                                    const uint8_t *,
+                                    size_t,
+                                    const ChunkHandler&) const {
+        throw error(LIBBSA_ERROR_ZLIB_ERROR, "Uncompressing of \"" + data.path + "\" failed.");
+    }
+
+    void GenericBsa::StreamData(const BsaAsset& data,
+                                const uint8_t * storedData,
+                                const ChunkHandler& handler) const {
+        const size_t storedSize = GetStoredSize(data);
+
+        if (IsCompressed(data)) {
+            UncompressData(data, storedData, storedSize, handler);
+            return;
+        }
+
+        for (size_t pos = 0; pos < storedSize; pos += ChunkSize) {
+            handler(storedData + pos, min(ChunkSize, storedSize - pos));
+        }
+    }
+
+    void GenericBsa::WriteAsset(const BsaAsset& asset,
+                                const uint8_t * storedData,
+                                const boost::filesystem::path& outFilePath) const {
+        try {
+            //Create parent directories.
+            fs::create_directories(outFilePath.parent_path());  //This creates any directories in the path that don't already exist.
 
-            //Write new file.
+            //Write new file, decompressing straight into it.
             boost::filesystem::ofstream out(outFilePath, ios::binary | ios::trunc);
             out.exceptions(ios::failbit | ios::badbit | ios::eofbit);  //Causes ifstream::failure to be thrown if problem is encountered.
 
-            out.write((char*)data, dataSize);
+            try {
+                StreamData(asset, storedData, [&out](const uint8_t * data, size_t size) {
+                    out.write((const char*)data, size);
+                });
+            }
+            catch (error&) {
+                //Don't leave a partially written file behind.
+                out.close();
+                boost::system::error_code ec;
+                fs::remove(outFilePath, ec);
+                throw;
+            }
 
             out.close();
         }
@@ -123,52 +776,505 @@ namespace libbsa {
         }
     }
 
-    void GenericBsa::Extract(const vector<BsaAsset>& assetsToExtract,
-                             const boost::filesystem::path& destRootPath,
-                             const bool overwrite) const {
-        for (const auto& asset : assetsToExtract) {
-            Extract(asset.path, destRootPath, overwrite);
+    void GenericBsa::CopyStoredData(const std::vector<BsaAsset>& sourceAssets,
+                                    std::ostream& out) const {
+        // If the archive is memory-mapped, data is written straight from the
+        // mapping, otherwise it's read into the same buffer each time.
+        vector<uint8_t> buffer;
+        uint64_t runOffset = 0;
+        uint64_t runSize = 0;
+        for (const auto& asset : sourceAssets) {
+            uint64_t size = GetStoredSize(asset);
+            if (runSize > 0 && asset.offset == runOffset + runSize && runSize + size <= MaxCopyRunSize) {
+                runSize += size;
+                continue;
+            }
+
+            if (runSize > 0)
+                out.write((const char*)ReadBytes(runOffset, runSize, buffer), runSize);
+
+            runOffset = asset.offset;
+            runSize = size;
         }
+
+        if (runSize > 0)
+            out.write((const char*)ReadBytes(runOffset, runSize, buffer), runSize);
     }
 
-    uint32_t GenericBsa::CalcChecksum(const std::string& assetPath) const {
-        const uint8_t * data;
-        size_t dataSize;
-        Extract(assetPath, &data, &dataSize);
+    uint32_t GenericBsa::GetStoredSize(const BsaAsset& data) const {
+        return data.size;
+    }
+
+    bool GenericBsa::IsCompressed(const BsaAsset&) const {
+        return false;
+    }
 
-        //Calculate the checksum now.
-        boost::crc_32_type result;
-        result.process_bytes(data, dataSize);
+    const uint8_t * GenericBsa::ReadBytes(uint64_t offset,
+                                          size_t size,
+                                          std::vector<uint8_t>& buffer) const {
+        const uint64_t archiveSize = file.GetSize();
+        if (offset > archiveSize || size > archiveSize - offset)
+            throw error(LIBBSA_ERROR_PARSE_FAIL, "Structure of \"" + filePath.string() + "\" is invalid.");
 
-        return result.checksum();
+        if (file.GetMapping() != NULL)
+            return file.GetMapping() + offset;
+
+        try {
+            buffer.resize(size);
+        }
+        catch (bad_alloc& e) {
+            throw error(LIBBSA_ERROR_NO_MEM, e.what());
+        }
+
+        file.Read(offset, size, buffer.data());
+
+        return buffer.data();
     }
 
-    std::string GenericBsa::ToUTF8(const std::string& str) {
+    bool GenericBsa::IsCacheable(const BsaAsset& asset) const {
+        return assetCache.IsEnabled() && (IsCompressed(asset) || file.GetMapping() == NULL);
+    }
+
+    AssetCache::Data GenericBsa::GetCachedData(const BsaAsset& asset) const {
+        AssetCache::Data data;
+        if (assetCache.Get(asset.offset, data))
+            return data;
+
+        pair<uint8_t*, size_t> dataPair = ReadData(asset);
         try {
-            return boost::locale::conv::to_utf<char>(str, "Windows-1252", boost::locale::conv::stop);
+            data.bytes.reset(dataPair.first, default_delete<uint8_t[]>());
         }
-        catch (boost::locale::conv::conversion_error& e) {
-            throw error(LIBBSA_ERROR_BAD_STRING, "\"" + str + "\" cannot be encoded in Windows-1252.");
+        catch (bad_alloc& e) {
+            throw error(LIBBSA_ERROR_NO_MEM, e.what());
         }
+        data.size = dataPair.second;
+
+        assetCache.Put(asset.offset, data);
+
+        return data;
     }
 
-    std::string GenericBsa::FromUTF8(const std::string& str) {
+    std::vector<GenericBsa::ReadRun> GenericBsa::GetReadRuns(const std::vector<const BsaAsset*>& sortedAssets) const {
+        vector<ReadRun> runs;
+        for (size_t i = 0; i < sortedAssets.size(); ++i) {
+            uint64_t start = sortedAssets[i]->offset;
+            uint64_t end = start + GetStoredSize(*sortedAssets[i]);
+
+            if (!runs.empty()) {
+                ReadRun& run = runs.back();
+                uint64_t runEnd = run.offset + run.size;
+                if (start >= run.offset && start <= runEnd + MaxReadRunGap && max(end, runEnd) - run.offset <= MaxReadRunSize) {
+                    run.size = max(end, runEnd) - run.offset;
+                    run.lastAsset = i + 1;
+                    continue;
+                }
+            }
+
+            ReadRun run;
+            run.offset = start;
+            run.size = end - start;
+            run.firstAsset = i;
+            run.lastAsset = i + 1;
+            runs.push_back(run);
+        }
+
+        return runs;
+    }
+
+    bool GenericBsa::FindAsset(const std::string& normalisedPath, BsaAsset * asset) const {
+        RequireAssets();
+
+        auto it = lower_bound(begin(sortedAssetIndex), end(sortedAssetIndex), normalisedPath, [&](uint32_t index, const string& path) {
+            return assets.CompareNormalisedPath(index, path) < 0;
+        });
+        if (it == end(sortedAssetIndex) || assets.CompareNormalisedPath(*it, normalisedPath) != 0)
+            return false;
+
+        if (asset != NULL)
+            *asset = assets[*it];
+
+        return true;
+    }
+
+    void GenericBsa::LoadAssets() {}
+
+    void GenericBsa::RequireAssets() const {
+        if (assetsLoaded)
+            return;
+
+        // Loading assets changes the archive's internal state, but not its
+        // contents, so is allowed from const functions.
+        call_once(assetsLoadedFlag, [this]() {
+            GenericBsa * bsa = const_cast<GenericBsa*>(this);
+            if (!bsa->ReadIndexCache()) {
+                bsa->LoadAssets();
+                WriteIndexCache();
+            }
+            assetsLoaded = true;
+        });
+    }
+
+    void GenericBsa::SetIndexCacheDirectory(const boost::filesystem::path& directory) {
+        lock_guard<mutex> lock(indexCacheMutex);
+        indexCacheDirectory = directory;
+    }
+
+    boost::filesystem::path GenericBsa::GetIndexCachePath() const {
+        fs::path directory;
+        {
+            lock_guard<mutex> lock(indexCacheMutex);
+            directory = indexCacheDirectory;
+        }
+
+        // Only formats that record where their records end can be cached.
+        if (directory.empty() || recordsSize == 0)
+            return fs::path();
+
+        // Name the cache after the archive's path. The path is also stored in
+        // the cache, in case two paths give the same name.
+        const string archivePath = fs::absolute(filePath).string();
+        char name[32];
+        snprintf(name, sizeof(name), "%08x.bsaidx", uint32_t(crc32(0, reinterpret_cast<const Bytef*>(archivePath.data()), archivePath.length())));
+
+        return directory / name;
+    }
+
+    uint32_t GenericBsa::GetRecordsChecksum() const {
+        vector<uint8_t> buffer;
+        const uint8_t * records = ReadBytes(0, recordsSize, buffer);
+
+        // zlib's crc32 takes a 32-bit length, so feed it in pieces.
+        uLong checksum = crc32(0, Z_NULL, 0);
+        for (uint64_t pos = 0; pos < recordsSize; pos += UINT32_MAX) {
+            uint64_t size = min<uint64_t>(recordsSize - pos, UINT32_MAX);
+            checksum = crc32(checksum, records + pos, size);
+        }
+
+        return checksum;
+    }
+
+    bool GenericBsa::ReadIndexCache() {
+        const fs::path cachePath = GetIndexCachePath();
+        if (cachePath.empty())
+            return false;
+
+        // The cache is optional, so any problem with it just means that the
+        // assets get loaded from the archive instead.
+        try {
+            if (!fs::exists(cachePath))
+                return false;
+
+            boost::iostreams::mapped_file_source cache(cachePath);
+            const uint8_t * data = reinterpret_cast<const uint8_t*>(cache.data());
+            const size_t size = cache.size();
+
+            IndexCacheHeader header;
+            if (size < sizeof(IndexCacheHeader))
+                return false;
+            memcpy(&header, data, sizeof(IndexCacheHeader));
+
+            const string archivePath = fs::absolute(filePath).string();
+            const size_t pathSize = (archivePath.length() + 7) / 8 * 8;
+            if (memcmp(header.magic, IndexCacheMagic, sizeof(header.magic)) != 0
+                || header.version != IndexCacheVersion
+                || header.archiveSize != file.GetSize()
+                || header.archiveTime != int64_t(fs::last_write_time(filePath))
+                || header.recordsSize != recordsSize
+                || header.pathLength != archivePath.length()
+                || sizeof(IndexCacheHeader) + pathSize > size
+                || memcmp(data + sizeof(IndexCacheHeader), archivePath.data(), archivePath.length()) != 0)
+                return false;
+
+            const uint64_t tableOffset = sizeof(IndexCacheHeader) + pathSize;
+            const uint64_t indexOffset = tableOffset + header.tableSize;
+            if (header.tableSize > size - tableOffset
+                || uint64_t(header.sortedIndexCount) * sizeof(uint32_t) > size - indexOffset)
+                return false;
+
+            // Checked last, as it reads all the archive's records.
+            if (header.recordsChecksum != GetRecordsChecksum())
+                return false;
+
+            if (!assets.Read(data + tableOffset, header.tableSize))
+                return false;
+
+            sortedAssetIndex.resize(header.sortedIndexCount);
+            memcpy(sortedAssetIndex.data(), data + indexOffset, sizeof(uint32_t) * header.sortedIndexCount);
+            for (const auto index : sortedAssetIndex) {
+                if (index >= assets.size()) {
+                    assets.clear();
+                    sortedAssetIndex.clear();
+                    return false;
+                }
+            }
+
+            BuildFolderIndex();
+
+            return true;
+        }
+        catch (std::exception&) {
+            assets.clear();
+            sortedAssetIndex.clear();
+            return false;
+        }
+    }
+
+    void GenericBsa::WriteIndexCache() const {
+        const fs::path cachePath = GetIndexCachePath();
+        if (cachePath.empty())
+            return;
+
+        // Write to a temporary file first, so that other processes never
+        // see a partial cache.
+        fs::path tempPath;
         try {
-            return boost::locale::conv::from_utf<char>(str, "Windows-1252", boost::locale::conv::stop);
+            const string archivePath = fs::absolute(filePath).string();
+
+            IndexCacheHeader header;
+            memcpy(header.magic, IndexCacheMagic, sizeof(header.magic));
+            header.version = IndexCacheVersion;
+            header.pathLength = archivePath.length();
+            header.archiveSize = file.GetSize();
+            header.archiveTime = fs::last_write_time(filePath);
+            header.recordsSize = recordsSize;
+            header.recordsChecksum = GetRecordsChecksum();
+            header.sortedIndexCount = sortedAssetIndex.size();
+            header.tableSize = assets.GetWrittenSize();
+
+            tempPath = cachePath.parent_path() / fs::unique_path("%%%%-%%%%-%%%%-%%%%.tmp");
+
+            boost::filesystem::ofstream out(tempPath, ios::binary | ios::trunc);
+            out.exceptions(ios::failbit | ios::badbit | ios::eofbit);
+
+            const char padding[8] = {0};
+            out.write(reinterpret_cast<const char*>(&header), sizeof(IndexCacheHeader));
+            out.write(archivePath.data(), archivePath.length());
+            out.write(padding, (8 - archivePath.length() % 8) % 8);
+            assets.Write(out);
+            out.write(reinterpret_cast<const char*>(sortedAssetIndex.data()), sizeof(uint32_t) * sortedAssetIndex.size());
+            out.close();
+
+            fs::rename(tempPath, cachePath);
         }
-        catch (boost::locale::conv::conversion_error& e) {
-            throw error(LIBBSA_ERROR_BAD_STRING, "\"" + str + "\" cannot be encoded in Windows-1252.");
+        catch (std::exception&) {
+            boost::system::error_code ec;
+            if (!tempPath.empty())
+                fs::remove(tempPath, ec);
         }
     }
 
-    std::string GenericBsa::NormaliseAssetPath(const std::string& assetPath) {
-        std::string out(boost::to_lower_copy(assetPath));
+    void GenericBsa::BuildAssetIndex() {
+        sortedAssetIndex.resize(assets.size());
+        for (size_t i = 0; i < assets.size(); ++i)
+            sortedAssetIndex[i] = i;
+
+        // Paths are compared as they're read from the asset table, so no
+        // normalised copies are made.
+        stable_sort(begin(sortedAssetIndex), end(sortedAssetIndex), [&](uint32_t first, uint32_t second) {
+            return assets.CompareNormalisedPaths(first, second) < 0;
+        });
+
+        // If an archive somehow holds duplicate paths, the first wins.
+        sortedAssetIndex.erase(unique(begin(sortedAssetIndex), end(sortedAssetIndex), [&](uint32_t first, uint32_t second) {
+            return assets.CompareNormalisedPaths(first, second) == 0;
+        }), end(sortedAssetIndex));
+
+        BuildFolderIndex();
+    }
+
+    void GenericBsa::BuildFolderIndex() {
+        // Assets in the same table folder are in the same normalised folder,
+        // unless their file name holds a separator.
+        vector<string> folderPaths;
+        vector<string> normalisedFolderPaths;
+        folderPaths.reserve(assets.GetFolderCount());
+        normalisedFolderPaths.reserve(assets.GetFolderCount());
+        for (uint32_t i = 0; i < assets.GetFolderCount(); ++i) {
+            folderPaths.push_back(assets.GetFolderName(i));
+            normalisedFolderPaths.push_back(NormaliseAssetPath(folderPaths.back()));
+        }
+
+        // Going through the paths in sorted order puts each folder's assets
+        // in order too.
+        folderIndex.clear();
+        folderIndex[""];
+        for (const auto index : sortedAssetIndex) {
+            string path;
+            string folder;
+            if (assets.HasNestedName(index)) {
+                path = assets.GetPath(index);
+                string normalisedPath = NormaliseAssetPath(path);
+
+                size_t pos = normalisedPath.rfind('\\');
+                folder = pos == string::npos ? "" : normalisedPath.substr(0, pos);
 
-        boost::replace_all(out, "/", "\\");
+                // Normalisation may have removed a leading separator.
+                path = path.substr(path.length() - normalisedPath.length(), folder.length());
+            }
+            else {
+                path = folderPaths[assets.GetFolder(index)];
+                folder = normalisedFolderPaths[assets.GetFolder(index)];
 
-        if (out[0] == '\\')
-            out = out.substr(1);
+                // Normalisation may have removed a leading separator.
+                path = path.substr(path.length() - folder.length());
+            }
+
+            auto result = folderIndex.emplace(folder, FolderEntry());
+            result.first->second.assetIndices.push_back(index);
+
+            // Add any new folders to their parents, up to one that already existed.
+            while (result.second) {
+                result.first->second.path = path.substr(0, folder.length());
+
+                size_t pos = folder.rfind('\\');
+                string parent = pos == string::npos ? "" : folder.substr(0, pos);
+
+                auto parentResult = folderIndex.emplace(parent, FolderEntry());
+                parentResult.first->second.subfolders.push_back(folder);
+
+                folder = parent;
+                result = parentResult;
+            }
+        }
+
+        for (auto& folder : folderIndex)
+            sort(begin(folder.second.subfolders), end(folder.second.subfolders));
+    }
+
+    std::string GenericBsa::ToUTF8(const std::string& str) {
+        // Almost all asset paths are ASCII, which is the same in both.
+        const size_t asciiLength = GetAsciiLength(str);
+        if (asciiLength == str.length())
+            return str;
+
+        string out(str, 0, asciiLength);
+        out.reserve(str.length() + 2 * (str.length() - asciiLength));
+        for (size_t i = asciiLength; i < str.length(); ++i) {
+            uint8_t c = str[i];
+            if (c < 0x80) {
+                out += c;
+                continue;
+            }
+
+            uint32_t codePoint = c < 0xA0 ? Windows1252Table[c - 0x80] : c;
+            if (codePoint == 0)
+                throw error(LIBBSA_ERROR_BAD_STRING, "\"" + str + "\" cannot be encoded in Windows-1252.");
+
+            if (codePoint < 0x800) {
+                out += char(0xC0 | (codePoint >> 6));
+            }
+            else {
+                out += char(0xE0 | (codePoint >> 12));
+                out += char(0x80 | ((codePoint >> 6) & 0x3F));
+            }
+            out += char(0x80 | (codePoint & 0x3F));
+        }
+
+        return out;
+    }
+
+    std::string GenericBsa::FromUTF8(const std::string& str) {
+        string out;
+        FromUTF8(str, out);
 
         return out;
     }
+
+    void GenericBsa::FromUTF8(const std::string& str, std::string& out) {
+        const size_t asciiLength = GetAsciiLength(str);
+        out.assign(str, 0, asciiLength);
+        for (size_t i = asciiLength; i < str.length();) {
+            uint8_t c = str[i];
+            if (c < 0x80) {
+                out += c;
+                i++;
+                continue;
+            }
+
+            // Decode the code point, rejecting invalid UTF-8. Windows-1252
+            // only encodes code points below 0x10000, so there's no need to
+            // decode any longer sequences.
+            uint32_t codePoint = 0;
+            size_t length = 0;
+            uint32_t minimum = 0;
+            if ((c & 0xE0) == 0xC0) {
+                codePoint = c & 0x1F;
+                length = 2;
+                minimum = 0x80;
+            }
+            else if ((c & 0xF0) == 0xE0) {
+                codePoint = c & 0x0F;
+                length = 3;
+                minimum = 0x800;
+            }
+            else
+                throw error(LIBBSA_ERROR_BAD_STRING, "\"" + str + "\" cannot be encoded in Windows-1252.");
+
+            if (length > str.length() - i)
+                throw error(LIBBSA_ERROR_BAD_STRING, "\"" + str + "\" cannot be encoded in Windows-1252.");
+
+            for (size_t j = 1; j < length; ++j) {
+                uint8_t continuation = str[i + j];
+                if ((continuation & 0xC0) != 0x80)
+                    throw error(LIBBSA_ERROR_BAD_STRING, "\"" + str + "\" cannot be encoded in Windows-1252.");
+
+                codePoint = (codePoint << 6) | (continuation & 0x3F);
+            }
+            i += length;
+
+            if (codePoint < minimum)
+                throw error(LIBBSA_ERROR_BAD_STRING, "\"" + str + "\" cannot be encoded in Windows-1252.");
+
+            if (codePoint >= 0xA0 && codePoint <= 0xFF) {
+                out += char(codePoint);
+                continue;
+            }
+
+            const uint16_t * entry = find(begin(Windows1252Table), end(Windows1252Table), codePoint);
+            if (entry == end(Windows1252Table))
+                throw error(LIBBSA_ERROR_BAD_STRING, "\"" + str + "\" cannot be encoded in Windows-1252.");
+
+            out += char(0x80 + (entry - begin(Windows1252Table)));
+        }
+    }
+
+    size_t GenericBsa::GetAsciiLength(const std::string& str) {
+        const char * data = str.data();
+        const size_t length = str.length();
+
+        // Check a word at a time for bytes with their high bit set, then
+        // find the first one byte by byte.
+        size_t i = 0;
+        for (; i + sizeof(uint64_t) <= length; i += sizeof(uint64_t)) {
+            uint64_t word;
+            memcpy(&word, data + i, sizeof(uint64_t));
+            if (word & 0x8080808080808080ULL)
+                break;
+        }
+
+        while (i < length && uint8_t(data[i]) < 0x80)
+            i++;
+
+        return i;
+    }
+
+    std::string GenericBsa::NormaliseAssetPath(const std::string& assetPath) {
+        string out;
+        libbsa::NormaliseAssetPath(assetPath.data(), assetPath.length(), out);
+
+        return out;
+    }
+
+    bool GenericBsa::NameEquals(const char * name, size_t length, const char * normalisedName, size_t normalisedLength) {
+        if (length != normalisedLength)
+            return false;
+
+        //Stored names are matched the same way that paths are normalised.
+        for (size_t i = 0; i < length; i++) {
+            if (NormaliseAssetPathChar(name[i]) != normalisedName[i])
+                return false;
+        }
+
+        return true;
+    }
 }
@@ -24,11 +24,20 @@
 #ifndef __LIBBSA_GENERICBSA_H__
 #define __LIBBSA_GENERICBSA_H__
 
+#include "archive_file.h"
+#include "asset_cache.h"
+#include "asset_table.h"
 #include "bsa_asset.h"
+#include "error.h"
 #include <stdint.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
-#include <list>
 #include <regex>
+#include <unordered_map>
+#include <vector>
 
 #include <boost/filesystem/fstream.hpp>
 
@@ -36,15 +45,57 @@ namespace libbsa {
     // Class for generic BSA data manipulation functions.
     struct GenericBsa {
     public:
-        GenericBsa(const boost::filesystem::path& path);
+        // Receives successive chunks of an asset's data.
+        typedef std::function<void(const uint8_t * data, size_t size)> ChunkHandler;
 
+        // Receives the data of the asset at the given index in a list of
+        // assets being extracted. If the asset couldn't be extracted, e is
+        // the error that stopped it, and data is NULL.
+        typedef std::function<void(size_t index,
+                                   const error * e,
+                                   const uint8_t * data,
+                                   size_t size)> AssetHandler;
+
+        // Takes ownership of the archive file, which is kept open for the
+        // lifetime of the object.
+        GenericBsa(const boost::filesystem::path& path, ArchiveFile&& archiveFile);
+        virtual ~GenericBsa() {}
+
+        // Saves the archive to the given path. If its assets need
+        // recompressing, threadCount worker threads are used, or one per
+        // hardware thread if threadCount is 0.
         virtual void Save(const boost::filesystem::path& path,
                           const uint32_t version,
-                          const uint32_t compression) = 0;
+                          const uint32_t compression,
+                          unsigned int threadCount) = 0;
 
         bool HasAsset(const std::string& assetPath) const;
+
+        // Checks which of the given assets are in the archive, setting
+        // results[i] to whether assetPaths[i] was found. Once the archive's
+        // assets are loaded, the paths are sorted and found in one pass.
+        void HasAssets(const char * const * assetPaths,
+                       size_t count,
+                       bool * results) const;
         BsaAsset GetAsset(const std::string& assetPath) const;
-        std::vector<BsaAsset> GetMatchingAssets(const std::regex& regex) const;
+        std::vector<BsaAsset> GetMatchingAssets(const std::regex& regex,
+                                                const std::string& pattern) const;
+
+        // Gets the assets whose paths match the given glob. Matching is
+        // case-insensitive and treats forward slashes as backslashes. '?'
+        // matches any one character other than a path separator, '*' matches
+        // any number of characters other than a path separator, and '**'
+        // matches any number of characters.
+        std::vector<BsaAsset> GetMatchingAssets(const std::string& glob) const;
+
+        // Gets the normalised paths of all the archive's assets, as
+        // NormaliseAssetPath would give them, in sorted order.
+        std::vector<std::string> GetNormalisedAssetPaths() const;
+
+        // Gets the paths of the subfolders and assets directly inside the
+        // given folder, in that order. Subfolder paths end in a backslash.
+        // An empty folder path gives the contents of the archive's root.
+        std::vector<std::string> GetFolderContents(const std::string& folderPath) const;
 
         void Extract(const std::string& assetPath,
                      const uint8_t ** const data,
@@ -54,26 +105,267 @@ namespace libbsa {
                      const boost::filesystem::path& destRootPath,
                      const bool overwrite) const;
 
+        // Passes the asset's data to the handler in chunks of at most
+        // ChunkSize bytes, decompressing it as it goes, so that the whole
+        // uncompressed asset is never held in memory.
+        void Extract(const std::string& assetPath,
+                     const ChunkHandler& handler) const;
+
+        // Extracts the given assets using threadCount worker threads. If
+        // threadCount is 0, one thread per hardware thread is used.
         void Extract(const std::vector<BsaAsset>& assetsToExtract,
                      const boost::filesystem::path& destRootPath,
-                     const bool overwrite) const;
+                     const bool overwrite,
+                     unsigned int threadCount = 1) const;
+
+        // Passes the data of each of the given assets to the handler as soon
+        // as it's ready. The calling thread reads the archive, in the order
+        // that the assets' data is stored, while threadCount worker threads
+        // decompress assets and pass them to the handler, so the handler can
+        // be called from several threads at once. The data is only valid
+        // until the handler returns. Once cancelled is set, assets that
+        // haven't been started are skipped. If threadCount is 0, one worker
+        // per hardware thread is used.
+        void Extract(const std::vector<std::string>& assetPaths,
+                     const AssetHandler& handler,
+                     unsigned int threadCount,
+                     const std::atomic<bool>& cancelled) const;
+
+        // Outputs a view of the asset's data. If the asset is stored
+        // uncompressed in a memory-mapped archive, the view points into the
+        // mapping and an empty pointer is returned. Otherwise the view is of
+        // the returned buffer, which may be shared with the asset cache, and
+        // is only valid while the buffer is held.
+        std::shared_ptr<const uint8_t> ExtractView(const std::string& assetPath,
+                                                   const uint8_t ** const data,
+                                                   size_t * const size) const;
 
+        // Calculates the asset's CRC32 a chunk at a time as its data is
+        // decompressed, unless it goes through the asset cache.
         uint32_t CalcChecksum(const std::string& assetPath) const;
+
+        // The cache of uncompressed asset data used by in-memory extraction,
+        // views and checksums. It's disabled until given a capacity.
+        AssetCache& GetAssetCache() const;
+
+        // The maximum size of chunks passed to a ChunkHandler.
+        static const size_t ChunkSize = 64 * 1024;
+
+        // Sets the directory that loaded asset indices are cached in, so
+        // that later handles for the same archive can read them instead of
+        // decoding the archive's records. An empty path disables caching.
+        static void SetIndexCacheDirectory(const boost::filesystem::path& directory);
     protected:
         // Reads the asset data into memory, at .first, with size .second.
         // Remember to free the memory once used.
-        virtual std::pair<uint8_t*, size_t> ReadData(std::ifstream& in,
-                                                     const BsaAsset& data) const = 0;
+        std::pair<uint8_t*, size_t> ReadData(const BsaAsset& data) const;
+
+        // Uncompresses the asset's stored data into memory, at .first, with
+        // size .second. Remember to free the memory once used.
+        virtual std::pair<uint8_t*, size_t> UncompressData(const BsaAsset& data,
+                                                           const uint8_t * storedData,
+                                                           size_t storedSize) const;
+
+        // Uncompresses the asset's stored data a chunk at a time, passing
+        // each chunk to the handler.
+        virtual void UncompressData(const BsaAsset& data,
+                                    const uint8_t * storedData,
+                                    size_t storedSize,
+                                    const ChunkHandler& handler) const;
+
+        // Passes the stored data to the handler in chunks, uncompressing it
+        // if necessary.
+        void StreamData(const BsaAsset& data,
+                        const uint8_t * storedData,
+                        const ChunkHandler& handler) const;
+
+        // Uncompresses the stored data if necessary, then writes it to the
+        // given file, creating parent directories as necessary.
+        void WriteAsset(const BsaAsset& asset,
+                        const uint8_t * storedData,
+                        const boost::filesystem::path& outFilePath) const;
+
+        // Writes the stored data of the given assets to out, in order. Assets
+        // whose data is stored contiguously are copied in one operation.
+        void CopyStoredData(const std::vector<BsaAsset>& sourceAssets,
+                            std::ostream& out) const;
+
+        // Looks up the asset with the given normalised path, outputting it
+        // if asset isn't NULL. Formats that open lazily can override this to
+        // look up assets without loading them all.
+        virtual bool FindAsset(const std::string& normalisedPath,
+                               BsaAsset * asset) const;
+
+        // Populates the assets vector and builds the indices. Formats that
+        // open lazily set assetsLoaded to false in their constructor and
+        // override this, everything else loads assets when constructed.
+        virtual void LoadAssets();
+
+        // Makes sure that the assets have been loaded. Must be called before
+        // using the assets vector or indices from a public function.
+        void RequireAssets() const;
+
+        // Gets the size of the asset's data as it is stored in the archive.
+        virtual uint32_t GetStoredSize(const BsaAsset& data) const;
+
+        // Checks if the asset's data is stored compressed.
+        virtual bool IsCompressed(const BsaAsset& data) const;
+
+        // Gets a pointer to size bytes of the archive, starting at offset.
+        // If the archive is memory-mapped, the pointer is into the mapping and
+        // buffer is unused, otherwise the bytes are read into buffer. Either
+        // way, the pointer is only valid for as long as buffer is.
+        const uint8_t * ReadBytes(uint64_t offset,
+                                  size_t size,
+                                  std::vector<uint8_t>& buffer) const;
 
         const boost::filesystem::path filePath;
-        std::list<BsaAsset> assets;
+
+        // The archive is opened once, and kept open so that reads don't
+        // depend on filePath still resolving to it. Where possible it's also
+        // memory-mapped, so that reads don't need to copy. If mapping fails
+        // (eg. a 32-bit process can't find enough address space), reads are
+        // made from the file at their offsets instead.
+        ArchiveFile file;
+        AssetTable assets;
+        mutable std::atomic<bool> assetsLoaded;
+
+        // The size of the header and records at the start of the archive,
+        // which the asset table is built from. Formats that open lazily set
+        // this so that their loaded assets can be cached.
+        uint64_t recordsSize;
+
+        // Rebuilds the normalised path lookup index. Must be called whenever
+        // assets are added to or reordered in the asset table.
+        void BuildAssetIndex();
 
         // Only ever need to convert between Windows-1252 and UTF-8.
         static std::string ToUTF8(const std::string& str);
         static std::string FromUTF8(const std::string& str);
 
-        // Replaces all forwardslashes with backslashes, and lowercases letters.
+        // Writes the Windows-1252 form of the given string to out, reusing
+        // its storage.
+        static void FromUTF8(const std::string& str, std::string& out);
+
+        // Replaces all forwardslashes with backslashes, lowercases ASCII
+        // letters and removes any leading separator. See asset_path.h.
         static std::string NormaliseAssetPath(const std::string& assetPath);
+
+        // Checks if a name stored in the archive is the same as a normalised
+        // Windows-1252 name, without transcoding or normalising the stored
+        // name first.
+        static bool NameEquals(const char * name,
+                               size_t length,
+                               const char * normalisedName,
+                               size_t normalisedLength);
+    private:
+        // A range of the archive holding the data for a group of assets, which
+        // are read together during batch extraction.
+        struct ReadRun {
+            uint64_t offset;
+            uint64_t size;
+            size_t firstAsset;
+            size_t lastAsset;
+        };
+
+        // Assets separated by fewer bytes than this are read in one go, and
+        // runs are split once they get bigger than the maximum size.
+        static const uint64_t MaxReadRunGap = 64 * 1024;
+        static const uint64_t MaxReadRunSize = 16 * 1024 * 1024;
+
+        // Contiguous data is copied in pieces of at most this size when saving.
+        static const uint64_t MaxCopyRunSize = 8 * 1024 * 1024;
+
+        mutable AssetCache assetCache;
+
+        // Checks if the asset's data goes through the asset cache. Only data
+        // that must be decompressed or read from an unmapped archive does, as
+        // anything else can already be copied straight from the mapping.
+        bool IsCacheable(const BsaAsset& asset) const;
+
+        // Gets the asset's uncompressed data from the asset cache, reading it
+        // and adding it to the cache if it isn't there.
+        AssetCache::Data GetCachedData(const BsaAsset& asset) const;
+
+        // Groups the given assets, which must be sorted by offset, into runs.
+        std::vector<ReadRun> GetReadRuns(const std::vector<const BsaAsset*>& sortedAssets) const;
+
+        // Gets the assets whose normalised paths start with the given prefix
+        // and satisfy the predicate, in the order they're stored in assets.
+        std::vector<BsaAsset> GetMatchingAssets(const std::string& prefix,
+                                                const std::function<bool(const std::string& normalisedPath, const std::string& path)>& predicate) const;
+
+        // Gets the literal text that all of the pattern's matches must start
+        // with, normalised, or an empty string if there is none.
+        static std::string GetLiteralPrefix(const std::string& regex);
+        static std::string GetGlobLiteralPrefix(const std::string& glob);
+
+        // Matches a normalised glob against a normalised path.
+        static bool GlobMatch(const char * glob, const char * path);
+
+        // Gets the length of the ASCII characters at the start of the string.
+        static size_t GetAsciiLength(const std::string& str);
+
+        mutable std::once_flag assetsLoadedFlag;
+
+        // The start of an index cache file. It's followed by the archive's
+        // absolute path, the written asset table and the sorted asset index,
+        // each padded to a multiple of 8 bytes.
+        struct IndexCacheHeader {
+            char magic[8];
+            uint32_t version;
+            uint32_t pathLength;
+            uint64_t archiveSize;
+            int64_t archiveTime;
+            uint64_t recordsSize;
+            uint32_t recordsChecksum;
+            uint32_t sortedIndexCount;
+            uint64_t tableSize;
+        };
+
+        static const char IndexCacheMagic[8];
+        static const uint32_t IndexCacheVersion = 1;
+
+        static boost::filesystem::path indexCacheDirectory;
+        static std::mutex indexCacheMutex;
+
+        // Gets the path of the archive's index cache, or an empty path if it
+        // can't be cached.
+        boost::filesystem::path GetIndexCachePath() const;
+
+        // Gets the CRC32 of the archive's header and records.
+        uint32_t GetRecordsChecksum() const;
+
+        // Loads the asset table and index from the archive's index cache,
+        // returning false if there is no valid cache for the archive.
+        bool ReadIndexCache();
+        void WriteIndexCache() const;
+
+        // Rebuilds the folder index from the asset table and sorted index.
+        void BuildFolderIndex();
+
+        // A folder in the tree formed by the asset paths.
+        struct FolderEntry {
+            // The folder's path, as it appears in asset paths.
+            std::string path;
+
+            // The positions in the asset table of the assets directly
+            // inside the folder, sorted by path.
+            std::vector<uint32_t> assetIndices;
+
+            // The normalised paths of the folder's subfolders, sorted.
+            std::vector<std::string> subfolders;
+        };
+
+        // Maps normalised folder paths to their contents. The root folder's
+        // path is an empty string.
+        std::unordered_map<std::string, FolderEntry> folderIndex;
+
+        // The positions in the asset table of the assets sorted by normalised
+        // path, so that an asset or the assets with paths starting with a
+        // given prefix can be found by binary search. If an archive somehow
+        // holds duplicate paths, only the first is included.
+        std::vector<uint32_t> sortedAssetIndex;
     };
 }
 
@@ -0,0 +1,79 @@
+/*  libbsa
+
+    A library for reading and writing BSA files.
+
+    Copyright (C) 2012-2013    WrinklyNinja
+
+    This file is part of libbsa.
+
+    libbsa is free software: you can redistribute
+    it and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation, either version 3 of
+    the License, or (at your option) any later version.
+
+    libbsa is distributed in the hope that it will
+    be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libbsa.  If not, see
+    <http://www.gnu.org/licenses/>.
+*/
+
+#include "inflater.h"
+
+#ifdef LIBBSA_USE_LIBDEFLATE
+#   include <libdeflate.h>
+#else
+#   include <zlib.h>
+#endif
+
+namespace libbsa {
+#ifdef LIBBSA_USE_LIBDEFLATE
+    namespace {
+        // Decompressors are reusable but not thread-safe, so give each thread
+        // its own rather than allocating one per call.
+        struct Decompressor {
+            Decompressor() : decompressor(libdeflate_alloc_decompressor()) {}
+            ~Decompressor() {
+                if (decompressor != NULL)
+                    libdeflate_free_decompressor(decompressor);
+            }
+
+            libdeflate_decompressor * decompressor;
+        };
+    }
+
+    bool InflateBuffer(const uint8_t * in,
+                       size_t inSize,
+                       uint8_t * out,
+                       size_t& outSize) {
+        thread_local Decompressor d;
+        if (d.decompressor == NULL)
+            return false;
+
+        size_t actualOutSize;
+        libdeflate_result ret = libdeflate_zlib_decompress(d.decompressor, in, inSize, out, outSize, &actualOutSize);
+        if (ret != LIBDEFLATE_SUCCESS)
+            return false;
+
+        outSize = actualOutSize;
+        return true;
+    }
+#else
+    bool InflateBuffer(const uint8_t * in,
+                       size_t inSize,
+                       uint8_t * out,
+                       size_t& outSize) {
+        // zlib-ng is built in zlib-compatible mode, so this covers both.
+        uLongf uncompressedSize = outSize;
+        int ret = uncompress(out, &uncompressedSize, in, inSize);
+        if (ret != Z_OK)
+            return false;
+
+        outSize = uncompressedSize;
+        return true;
+    }
+#endif
+}
@@ -0,0 +1,41 @@
+/*  libbsa
+
+    A library for reading and writing BSA files.
+
+    Copyright (C) 2012-2013    WrinklyNinja
+
+    This file is part of libbsa.
+
+    libbsa is free software: you can redistribute
+    it and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation, either version 3 of
+    the License, or (at your option) any later version.
+
+    libbsa is distributed in the hope that it will
+    be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libbsa.  If not, see
+    <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __LIBBSA_INFLATER_H__
+#define __LIBBSA_INFLATER_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace libbsa {
+    // Inflates a complete zlib stream in one go, using whichever backend
+    // libbsa was built with (zlib, zlib-ng or libdeflate). outSize is the
+    // size of the output buffer, and is set to the number of bytes written.
+    // Returns false if the stream is invalid or doesn't fit in the buffer.
+    bool InflateBuffer(const uint8_t * in,
+                       size_t inSize,
+                       uint8_t * out,
+                       size_t& outSize);
+}
+
+#endif
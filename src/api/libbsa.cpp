@@ -22,6 +22,8 @@
 */
 
 #include "libbsa/libbsa.h"
+#include "_bsa_archive_set_handle_int.h"
+#include "_bsa_extraction_int.h"
 #include "_bsa_handle_int.h"
 #include "genericbsa.h"
 #include "tes3bsa.h"
@@ -33,6 +35,7 @@
 #include <boost/filesystem.hpp>
 #include <locale>
 #include <regex>
+#include <system_error>
 #include <unordered_set>
 
 using namespace std;
@@ -187,7 +190,10 @@ LIBBSA unsigned int bsa_save(bsa_handle bh,
         return c_error(LIBBSA_ERROR_INVALID_ARGS, "Cannot specify more than one compression level.");
 
     try {
-        bh->getBsa()->Save(path, version.to_ulong(), compression.to_ulong());
+        bh->getBsa()->Save(path, version.to_ulong(), compression.to_ulong(), bh->getExtractionThreads());
+    }
+    catch (bad_alloc& e) {
+        return c_error(LIBBSA_ERROR_NO_MEM, e.what());
     }
     catch (error& e) {
         return c_error(e.code(), e.what());
@@ -195,6 +201,10 @@ LIBBSA unsigned int bsa_save(bsa_handle bh,
     catch (ios_base::failure& e) {
         return c_error(LIBBSA_ERROR_FILESYSTEM_ERROR, e.what());
     }
+    catch (system_error& e) {
+        //A recompression worker thread couldn't be started.
+        return c_error(LIBBSA_ERROR_NO_MEM, e.what());
+    }
 
     return LIBBSA_OK;
 }
@@ -228,7 +238,7 @@ LIBBSA unsigned int bsa_get_assets(bsa_handle bh,
         regex regex = std::regex(assetRegex, regex::extended | regex::icase);
 
         //We don't know how many matches there will be, so put all matches into a temporary buffer first.
-        vector<BsaAsset> temp = bh->getBsa()->GetMatchingAssets(regex);
+        vector<BsaAsset> temp = bh->getBsa()->GetMatchingAssets(regex, assetRegex);
 
         if (temp.empty())
             return LIBBSA_OK;
@@ -252,6 +262,82 @@ LIBBSA unsigned int bsa_get_assets(bsa_handle bh,
     return LIBBSA_OK;
 }
 
+/* Gets an array of all the assets in the given BSA that match the glob. */
+LIBBSA unsigned int bsa_get_assets_by_glob(bsa_handle bh,
+                                           const char * const assetGlob,
+                                           const char * const ** const assetPaths,
+                                           size_t * const numAssets) {
+    if (bh == NULL || assetGlob == NULL || assetPaths == NULL || numAssets == NULL) //Check for valid args.
+        return c_error(LIBBSA_ERROR_INVALID_ARGS, "Null pointer passed.");
+
+    // Free memory if in use.
+    bh->freeExtAssets();
+
+    //Init values.
+    *assetPaths = NULL;
+    *numAssets = 0;
+
+    try {
+        //We don't know how many matches there will be, so put all matches into a temporary buffer first.
+        vector<BsaAsset> temp = bh->getBsa()->GetMatchingAssets(string(assetGlob));
+
+        if (temp.empty())
+            return LIBBSA_OK;
+
+        //Fill external array.
+        bh->setExtAssets(temp);
+    }
+    catch (bad_alloc& e) {
+        return c_error(LIBBSA_ERROR_NO_MEM, e.what());
+    }
+    catch (error& e) {
+        return c_error(e.code(), e.what());
+    }
+
+    *assetPaths = bh->getExtAssets();
+    *numAssets = bh->getExtAssetsNum();
+
+    return LIBBSA_OK;
+}
+
+/* Gets an array of the subfolders and assets directly inside the given
+   folder in the given BSA. */
+LIBBSA unsigned int bsa_get_folder_contents(bsa_handle bh,
+                                            const char * const folderPath,
+                                            const char * const ** const contentPaths,
+                                            size_t * const numContents) {
+    if (bh == NULL || folderPath == NULL || contentPaths == NULL || numContents == NULL) //Check for valid args.
+        return c_error(LIBBSA_ERROR_INVALID_ARGS, "Null pointer passed.");
+
+    // Free memory if in use.
+    bh->freeExtAssets();
+
+    //Init values.
+    *contentPaths = NULL;
+    *numContents = 0;
+
+    try {
+        vector<string> temp = bh->getBsa()->GetFolderContents(folderPath);
+
+        if (temp.empty())
+            return LIBBSA_OK;
+
+        //Fill external array.
+        bh->setExtAssets(temp);
+    }
+    catch (bad_alloc& e) {
+        return c_error(LIBBSA_ERROR_NO_MEM, e.what());
+    }
+    catch (error& e) {
+        return c_error(e.code(), e.what());
+    }
+
+    *contentPaths = bh->getExtAssets();
+    *numContents = bh->getExtAssetsNum();
+
+    return LIBBSA_OK;
+}
+
 /* Checks if a specific asset, found within the BSA at assetPath, is in the given BSA. */
 LIBBSA unsigned int bsa_contains_asset(bsa_handle bh,
                                        const char * const assetPath,
@@ -259,7 +345,50 @@ LIBBSA unsigned int bsa_contains_asset(bsa_handle bh,
     if (bh == NULL || assetPath == NULL || result == NULL) //Check for valid args.
         return c_error(LIBBSA_ERROR_INVALID_ARGS, "Null pointer passed.");
 
-    *result = bh->getBsa()->HasAsset(assetPath);
+    try {
+        *result = bh->getBsa()->HasAsset(assetPath);
+    }
+    catch (bad_alloc& e) {
+        return c_error(LIBBSA_ERROR_NO_MEM, e.what());
+    }
+    catch (error& e) {
+        return c_error(e.code(), e.what());
+    }
+
+    return LIBBSA_OK;
+}
+
+LIBBSA unsigned int bsa_contains_assets(bsa_handle bh,
+                                        const char * const * const assetPaths,
+                                        const size_t numAssets,
+                                        bool * const results) {
+    if (bh == NULL || (numAssets > 0 && (assetPaths == NULL || results == NULL))) //Check for valid args.
+        return c_error(LIBBSA_ERROR_INVALID_ARGS, "Null pointer passed.");
+
+    for (size_t i = 0; i < numAssets; ++i) {
+        if (assetPaths[i] == NULL)
+            return c_error(LIBBSA_ERROR_INVALID_ARGS, "Null pointer passed.");
+    }
+
+    try {
+        bh->getBsa()->HasAssets(assetPaths, numAssets, results);
+    }
+    catch (bad_alloc& e) {
+        return c_error(LIBBSA_ERROR_NO_MEM, e.what());
+    }
+    catch (error& e) {
+        return c_error(e.code(), e.what());
+    }
+
+    return LIBBSA_OK;
+}
+
+/* Frees the array of paths output to the calling thread. */
+LIBBSA unsigned int bsa_release_asset_paths(bsa_handle bh) {
+    if (bh == NULL) //Check for valid args.
+        return c_error(LIBBSA_ERROR_INVALID_ARGS, "Null pointer passed.");
+
+    bh->freeExtAssets();
 
     return LIBBSA_OK;
 }
@@ -289,12 +418,12 @@ LIBBSA unsigned int bsa_extract_assets(bsa_handle bh,
         regex regex = std::regex(string(reinterpret_cast<const char*>(assetRegex)), regex::extended | regex::icase);
 
         //We don't know how many matches there will be, so put all matches into a temporary buffer first.
-        vector<BsaAsset> temp = bh->getBsa()->GetMatchingAssets(regex);
+        vector<BsaAsset> temp = bh->getBsa()->GetMatchingAssets(regex, assetRegex);
 
         if (temp.empty())
             return LIBBSA_OK;
 
-        bh->getBsa()->Extract(temp, string(reinterpret_cast<const char*>(destPath)), overwrite);
+        bh->getBsa()->Extract(temp, string(reinterpret_cast<const char*>(destPath)), overwrite, bh->getExtractionThreads());
 
         bh->setExtAssets(temp);
     }
@@ -314,6 +443,87 @@ LIBBSA unsigned int bsa_extract_assets(bsa_handle bh,
     return LIBBSA_OK;
 }
 
+/* Extracts all assets in the given BSA that match the glob to the given
+   destination path. */
+LIBBSA unsigned int bsa_extract_assets_by_glob(bsa_handle bh,
+                                               const char * const assetGlob,
+                                               const char * const destPath,
+                                               const char * const ** const assetPaths,
+                                               size_t * const numAssets,
+                                               const bool overwrite) {
+    if (bh == NULL || assetGlob == NULL || destPath == NULL || assetPaths == NULL || numAssets == NULL) //Check for valid args.
+        return c_error(LIBBSA_ERROR_INVALID_ARGS, "Null pointer passed.");
+
+    //Free memory if in use.
+    bh->freeExtAssets();
+
+    //Init values.
+    *assetPaths = NULL;
+    *numAssets = 0;
+
+    try {
+        //We don't know how many matches there will be, so put all matches into a temporary buffer first.
+        vector<BsaAsset> temp = bh->getBsa()->GetMatchingAssets(string(assetGlob));
+
+        if (temp.empty())
+            return LIBBSA_OK;
+
+        bh->getBsa()->Extract(temp, string(reinterpret_cast<const char*>(destPath)), overwrite, bh->getExtractionThreads());
+
+        bh->setExtAssets(temp);
+    }
+    catch (bad_alloc& e) {
+        return c_error(LIBBSA_ERROR_NO_MEM, e.what());
+    }
+    catch (error& e) {
+        return c_error(e.code(), e.what());
+    }
+
+    *assetPaths = bh->getExtAssets();
+    *numAssets = bh->getExtAssetsNum();
+
+    return LIBBSA_OK;
+}
+
+/* Sets the number of threads that bsa_extract_assets() uses. */
+LIBBSA unsigned int bsa_set_extraction_threads(bsa_handle bh,
+                                               const unsigned int threads) {
+    if (bh == NULL) //Check for valid args.
+        return c_error(LIBBSA_ERROR_INVALID_ARGS, "Null pointer passed.");
+
+    bh->setExtractionThreads(threads);
+
+    return LIBBSA_OK;
+}
+
+/* Sets the number of bytes of uncompressed asset data that are cached. */
+LIBBSA unsigned int bsa_set_asset_cache_size(bsa_handle bh,
+                                             const size_t size) {
+    if (bh == NULL) //Check for valid args.
+        return c_error(LIBBSA_ERROR_INVALID_ARGS, "Null pointer passed.");
+
+    bh->getBsa()->GetAssetCache().SetCapacity(size);
+
+    return LIBBSA_OK;
+}
+
+/* Gets the number of asset cache hits and misses, and the size of the cached
+   data. */
+LIBBSA unsigned int bsa_get_asset_cache_stats(bsa_handle bh,
+                                              uint64_t * const hits,
+                                              uint64_t * const misses,
+                                              size_t * const size) {
+    if (bh == NULL || hits == NULL || misses == NULL || size == NULL) //Check for valid args.
+        return c_error(LIBBSA_ERROR_INVALID_ARGS, "Null pointer passed.");
+
+    const AssetCache& cache = bh->getBsa()->GetAssetCache();
+    *hits = cache.GetHits();
+    *misses = cache.GetMisses();
+    *size = cache.GetSize();
+
+    return LIBBSA_OK;
+}
+
 /* Extracts a specific asset, found at assetPath, from a given BSA, to destPath. */
 LIBBSA unsigned int bsa_extract_asset(bsa_handle bh,
                                       const char * const assetPath,
@@ -325,6 +535,38 @@ LIBBSA unsigned int bsa_extract_asset(bsa_handle bh,
     try {
         bh->getBsa()->Extract(assetPath, string(reinterpret_cast<const char*>(destPath)), overwrite);
     }
+    catch (bad_alloc& e) {
+        return c_error(LIBBSA_ERROR_NO_MEM, e.what());
+    }
+    catch (error& e) {
+        return c_error(e.code(), e.what());
+    }
+    catch (ios_base::failure& e) {
+        return c_error(LIBBSA_ERROR_FILESYSTEM_ERROR, e.what());
+    }
+    catch (boost::filesystem::filesystem_error& e) {
+        return c_error(LIBBSA_ERROR_FILESYSTEM_ERROR, e.what());
+    }
+
+    return LIBBSA_OK;
+}
+
+/* Extracts a specific asset, passing its data to a callback in chunks. */
+LIBBSA unsigned int bsa_extract_asset_to_callback(bsa_handle bh,
+                                                  const char * const assetPath,
+                                                  bsa_chunk_callback callback,
+                                                  void * userData) {
+    if (bh == NULL || assetPath == NULL || callback == NULL) //Check for valid args.
+        return c_error(LIBBSA_ERROR_INVALID_ARGS, "Null pointer passed.");
+
+    try {
+        bh->getBsa()->Extract(assetPath, [callback, userData](const uint8_t * data, size_t size) {
+            callback(data, size, userData);
+        });
+    }
+    catch (bad_alloc& e) {
+        return c_error(LIBBSA_ERROR_NO_MEM, e.what());
+    }
     catch (error& e) {
         return c_error(e.code(), e.what());
     }
@@ -343,13 +585,294 @@ LIBBSA unsigned int bsa_extract_asset_to_memory(bsa_handle bh,
     try {
         bh->getBsa()->Extract(assetPath, _data, _size);
     }
+    catch (bad_alloc& e) {
+        return c_error(LIBBSA_ERROR_NO_MEM, e.what());
+    }
     catch (error& e) {
         return c_error(e.code(), e.what());
     }
+    catch (ios_base::failure& e) {
+        return c_error(LIBBSA_ERROR_FILESYSTEM_ERROR, e.what());
+    }
+    catch (boost::filesystem::filesystem_error& e) {
+        return c_error(LIBBSA_ERROR_FILESYSTEM_ERROR, e.what());
+    }
+
+    return LIBBSA_OK;
+}
+
+/* Gets a read-only view of a specific asset's data, without copying it if it
+   is stored uncompressed. */
+LIBBSA unsigned int bsa_get_asset_view(bsa_handle bh,
+                                       const char * const assetPath,
+                                       const uint8_t ** const data,
+                                       size_t * const size) {
+    if (bh == NULL || assetPath == NULL || data == NULL || size == NULL) //Check for valid args.
+        return c_error(LIBBSA_ERROR_INVALID_ARGS, "Null pointer passed.");
+
+    try {
+        shared_ptr<const uint8_t> buffer = bh->getBsa()->ExtractView(assetPath, data, size);
+        if (buffer)
+            bh->addOwnedView(buffer);
+    }
+    catch (bad_alloc& e) {
+        return c_error(LIBBSA_ERROR_NO_MEM, e.what());
+    }
+    catch (error& e) {
+        return c_error(e.code(), e.what());
+    }
+
+    return LIBBSA_OK;
+}
+
+/* Releases a view obtained using bsa_get_asset_view(). */
+LIBBSA unsigned int bsa_release_asset_view(bsa_handle bh,
+                                           const uint8_t * const data) {
+    if (bh == NULL || data == NULL) //Check for valid args.
+        return c_error(LIBBSA_ERROR_INVALID_ARGS, "Null pointer passed.");
+
+    bh->releaseView(data);
+
+    return LIBBSA_OK;
+}
+
+/*--------------------------------
+   Asynchronous Extraction Functions
+--------------------------------*/
+
+/* Starts extracting the given assets in the background, passing each to the
+   callback as it's ready. */
+LIBBSA unsigned int bsa_extract_assets_async(bsa_handle bh,
+                                             const char * const * const assetPaths,
+                                             const size_t numAssets,
+                                             bsa_asset_callback callback,
+                                             void * userData,
+                                             bsa_extraction_handle * const eh) {
+    if (bh == NULL || (numAssets > 0 && assetPaths == NULL) || callback == NULL || eh == NULL) //Check for valid args.
+        return c_error(LIBBSA_ERROR_INVALID_ARGS, "Null pointer passed.");
+
+    try {
+        vector<string> paths;
+        paths.reserve(numAssets);
+        for (size_t i = 0; i < numAssets; ++i) {
+            if (assetPaths[i] == NULL)
+                return c_error(LIBBSA_ERROR_INVALID_ARGS, "Null pointer passed.");
+
+            paths.push_back(assetPaths[i]);
+        }
+
+        // The error message is stored per thread, so it's set on the thread
+        // that calls the callback.
+        *eh = new _bsa_extraction_int(*bh->getBsa(), paths, bh->getExtractionThreads(),
+                                      [callback, userData](size_t index, const error * e, const uint8_t * data, size_t size) {
+            if (e != NULL)
+                callback(index, c_error(e->code(), e->what()), NULL, 0, userData);
+            else
+                callback(index, LIBBSA_OK, data, size, userData);
+        });
+    }
+    catch (bad_alloc& e) {
+        return c_error(LIBBSA_ERROR_NO_MEM, e.what());
+    }
+    catch (system_error& e) {
+        return c_error(LIBBSA_ERROR_NO_MEM, e.what());
+    }
+
+    return LIBBSA_OK;
+}
+
+/* Waits for an asynchronous extraction to finish. */
+LIBBSA unsigned int bsa_extraction_wait(bsa_extraction_handle eh) {
+    if (eh == NULL) //Check for valid args.
+        return c_error(LIBBSA_ERROR_INVALID_ARGS, "Null pointer passed.");
+
+    try {
+        eh->wait();
+    }
+    catch (bad_alloc& e) {
+        return c_error(LIBBSA_ERROR_NO_MEM, e.what());
+    }
+    catch (error& e) {
+        return c_error(e.code(), e.what());
+    }
+    catch (ios_base::failure& e) {
+        return c_error(LIBBSA_ERROR_FILESYSTEM_ERROR, e.what());
+    }
+    catch (exception& e) {
+        //Anything else, eg. failing to start a worker thread, is from
+        //running out of resources.
+        return c_error(LIBBSA_ERROR_NO_MEM, e.what());
+    }
+
+    return LIBBSA_OK;
+}
+
+/* Checks if an asynchronous extraction has finished. */
+LIBBSA unsigned int bsa_extraction_is_complete(bsa_extraction_handle eh,
+                                               bool * const result) {
+    if (eh == NULL || result == NULL) //Check for valid args.
+        return c_error(LIBBSA_ERROR_INVALID_ARGS, "Null pointer passed.");
+
+    *result = eh->isComplete();
+
+    return LIBBSA_OK;
+}
+
+/* Cancels an asynchronous extraction if it's still running, then closes its
+   handle. */
+LIBBSA void bsa_extraction_close(bsa_extraction_handle eh) {
+    delete eh;
+}
+
+/*--------------------------------
+   Archive Set Functions
+--------------------------------*/
+
+/* Opens the BSA files at the given paths, in load order, returning a handle
+   for the set. */
+LIBBSA unsigned int bsa_archive_set_open(bsa_archive_set_handle * const sh,
+                                         const char * const * const paths,
+                                         const size_t numPaths) {
+    if (sh == NULL || (numPaths > 0 && paths == NULL))  //Check for valid args.
+        return c_error(LIBBSA_ERROR_INVALID_ARGS, "Null pointer passed.");
+
+    //Set the locale to get encoding conversions working correctly.
+    std::locale::global(std::locale(std::locale(), new std::codecvt_utf8_utf16<wchar_t>));
+    boost::filesystem::path::imbue(std::locale());
+
+    vector<boost::filesystem::path> archivePaths;
+    for (size_t i = 0; i < numPaths; ++i) {
+        if (paths[i] == NULL)
+            return c_error(LIBBSA_ERROR_INVALID_ARGS, "Null pointer passed.");
+        if (!boost::filesystem::exists(paths[i]))
+            return c_error(LIBBSA_ERROR_INVALID_ARGS, "Given path does not exist.");
+
+        archivePaths.push_back(paths[i]);
+    }
+
+    try {
+        *sh = new _bsa_archive_set_handle_int(archivePaths);
+    }
+    catch (bad_alloc& e) {
+        return c_error(LIBBSA_ERROR_NO_MEM, e.what());
+    }
+    catch (error& e) {
+        return c_error(e.code(), e.what());
+    }
+    catch (ios_base::failure& e) {
+        return c_error(LIBBSA_ERROR_FILESYSTEM_ERROR, e.what());
+    }
+
+    return LIBBSA_OK;
+}
+
+/* Closes a BSA set handle and the BSA handles it holds. */
+LIBBSA void bsa_archive_set_close(bsa_archive_set_handle sh) {
+    delete sh;
+}
+
+/* Gets the handle of the BSA at the given index in a set. */
+LIBBSA unsigned int bsa_archive_set_get_archive(bsa_archive_set_handle sh,
+                                                const size_t index,
+                                                bsa_handle * const bh) {
+    if (sh == NULL || bh == NULL) //Check for valid args.
+        return c_error(LIBBSA_ERROR_INVALID_ARGS, "Null pointer passed.");
+
+    if (index >= sh->getArchiveCount())
+        return c_error(LIBBSA_ERROR_INVALID_ARGS, "Archive index is out of range.");
+
+    *bh = sh->getArchive(index);
 
     return LIBBSA_OK;
 }
 
+LIBBSA unsigned int bsa_archive_set_contains_asset(bsa_archive_set_handle sh,
+                                                   const char * const assetPath,
+                                                   bool * const result) {
+    if (sh == NULL || assetPath == NULL || result == NULL) //Check for valid args.
+        return c_error(LIBBSA_ERROR_INVALID_ARGS, "Null pointer passed.");
+
+    try {
+        size_t index;
+        *result = sh->findAsset(assetPath, index);
+    }
+    catch (bad_alloc& e) {
+        return c_error(LIBBSA_ERROR_NO_MEM, e.what());
+    }
+    catch (error& e) {
+        return c_error(e.code(), e.what());
+    }
+
+    return LIBBSA_OK;
+}
+
+/* Gets the index of the BSA in a set that the given asset resolves to. */
+LIBBSA unsigned int bsa_archive_set_get_asset_archive(bsa_archive_set_handle sh,
+                                                      const char * const assetPath,
+                                                      size_t * const index) {
+    if (sh == NULL || assetPath == NULL || index == NULL) //Check for valid args.
+        return c_error(LIBBSA_ERROR_INVALID_ARGS, "Null pointer passed.");
+
+    try {
+        if (!sh->findAsset(assetPath, *index))
+            return c_error(LIBBSA_ERROR_INVALID_ARGS, "Asset not found");
+    }
+    catch (bad_alloc& e) {
+        return c_error(LIBBSA_ERROR_NO_MEM, e.what());
+    }
+    catch (error& e) {
+        return c_error(e.code(), e.what());
+    }
+
+    return LIBBSA_OK;
+}
+
+/* Extracts an asset from the BSA in a set that it resolves to. */
+LIBBSA unsigned int bsa_archive_set_extract_asset(bsa_archive_set_handle sh,
+                                                  const char * const assetPath,
+                                                  const char * const destPath,
+                                                  const bool overwrite) {
+    if (sh == NULL || assetPath == NULL || destPath == NULL) //Check for valid args.
+        return c_error(LIBBSA_ERROR_INVALID_ARGS, "Null pointer passed.");
+
+    size_t index;
+    try {
+        if (!sh->findAsset(assetPath, index))
+            return c_error(LIBBSA_ERROR_INVALID_ARGS, "Asset not found");
+    }
+    catch (bad_alloc& e) {
+        return c_error(LIBBSA_ERROR_NO_MEM, e.what());
+    }
+    catch (error& e) {
+        return c_error(e.code(), e.what());
+    }
+
+    return bsa_extract_asset(sh->getArchive(index), assetPath, destPath, overwrite);
+}
+
+/* Extracts an asset from the BSA in a set that it resolves to into memory. */
+LIBBSA unsigned int bsa_archive_set_extract_asset_to_memory(bsa_archive_set_handle sh,
+                                                            const char * const assetPath,
+                                                            const uint8_t ** const data,
+                                                            size_t * const size) {
+    if (sh == NULL || assetPath == NULL || data == NULL || size == NULL) //Check for valid args.
+        return c_error(LIBBSA_ERROR_INVALID_ARGS, "Null pointer passed.");
+
+    size_t index;
+    try {
+        if (!sh->findAsset(assetPath, index))
+            return c_error(LIBBSA_ERROR_INVALID_ARGS, "Asset not found");
+    }
+    catch (bad_alloc& e) {
+        return c_error(LIBBSA_ERROR_NO_MEM, e.what());
+    }
+    catch (error& e) {
+        return c_error(e.code(), e.what());
+    }
+
+    return bsa_extract_asset_to_memory(sh->getArchive(index), assetPath, data, size);
+}
+
 /*--------------------------------
    Misc. Functions
 --------------------------------*/
@@ -363,9 +886,34 @@ LIBBSA unsigned int bsa_calc_checksum(bsa_handle bh,
     try {
         *checksum = bh->getBsa()->CalcChecksum(assetPath);
     }
+    catch (bad_alloc& e) {
+        return c_error(LIBBSA_ERROR_NO_MEM, e.what());
+    }
     catch (error& e) {
         return c_error(e.code(), e.what());
     }
+    catch (ios_base::failure& e) {
+        return c_error(LIBBSA_ERROR_FILESYSTEM_ERROR, e.what());
+    }
+    catch (boost::filesystem::filesystem_error& e) {
+        return c_error(LIBBSA_ERROR_FILESYSTEM_ERROR, e.what());
+    }
+
+    return LIBBSA_OK;
+}
+
+/* Sets the directory that asset indices are cached in, or disables caching
+   if the directory is NULL or empty. */
+LIBBSA unsigned int bsa_set_index_cache_directory(const char * const directory) {
+    if (directory == NULL || directory[0] == '\0') {
+        GenericBsa::SetIndexCacheDirectory(boost::filesystem::path());
+        return LIBBSA_OK;
+    }
+
+    if (!boost::filesystem::is_directory(directory))
+        return c_error(LIBBSA_ERROR_INVALID_ARGS, "Given path is not a directory.");
+
+    GenericBsa::SetIndexCacheDirectory(directory);
 
     return LIBBSA_OK;
 }
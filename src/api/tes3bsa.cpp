@@ -24,6 +24,8 @@
 #include "tes3bsa.h"
 #include "error.h"
 #include "libbsa/libbsa.h"
+#include <algorithm>
+#include <cstring>
 #include <boost/filesystem.hpp>
 
 namespace fs = boost::filesystem;
@@ -32,17 +34,21 @@ using namespace std;
 
 namespace libbsa {
     namespace tes3 {
-        BSA::BSA(const boost::filesystem::path& path)
-            : GenericBsa(path),
-            hashOffset(0) {
+        BSA::BSA(const boost::filesystem::path& path, ArchiveFile&& archiveFile)
+            : GenericBsa(path, std::move(archiveFile)),
+            hashOffset(0),
+            fileCount(0),
+            fileRecords(NULL),
+            filenameOffsets(NULL),
+            filenameRecords(NULL),
+            filenameRecordsSize(0),
+            hashRecords(NULL),
+            startOfData(0),
+            hashesSorted(true) {
             //Check if file exists.
-            if (fs::exists(path)) {
-                boost::filesystem::ifstream in(path, ios::binary);
-                in.exceptions(ios::failbit | ios::badbit | ios::eofbit);  //Causes ifstream::failure to be thrown if problem is encountered.
-
+            if (file.IsOpen()) {
                 Header header;
-                in.seekg(0, ios_base::beg);
-                in.read((char*)&header, sizeof(Header));
+                memcpy(&header, ReadBytes(0, sizeof(Header), recordsBuffer), sizeof(Header));
 
                 /* We want:
                 - file names
@@ -50,66 +56,49 @@ namespace libbsa {
                 - raw data offsets
                 - file hashes
 
-                Load the FileRecordData (size,offset), filename offsets, filename records and hashes into memory, then work on them there.
+                The FileRecordData (size,offset), filename offsets, filename records and hashes are contiguous, so get them all at once and keep them.
+                Asset paths are only decoded when they're needed, lookups use the hashes instead.
                 */
-                FileRecord * fileRecords;
-                uint32_t * filenameOffsets;
-                uint8_t * filenameRecords;
-                uint64_t * hashRecords;
-                uint32_t filenameRecordsSize = header.hashOffset - sizeof(FileRecord) * header.fileCount - sizeof(uint32_t) * header.fileCount;
-                try {
-                    fileRecords = new FileRecord[header.fileCount];
-                    in.read((char*)fileRecords, sizeof(FileRecord) * header.fileCount);
-
-                    filenameOffsets = new uint32_t[header.fileCount];
-                    in.read((char*)filenameOffsets, sizeof(uint32_t) * header.fileCount);
-
-                    filenameRecords = new uint8_t[filenameRecordsSize];
-                    in.read((char*)filenameRecords, sizeof(uint8_t) * filenameRecordsSize);
-
-                    hashRecords = new uint64_t[header.fileCount];
-                    in.read((char*)hashRecords, sizeof(uint64_t) * header.fileCount);
-                }
-                catch (bad_alloc& e) {
-                    throw error(LIBBSA_ERROR_NO_MEM, e.what());
-                }
-
-                in.close(); //No longer need the file open.
-
-                //All three arrays have the same ordering, so we just need to loop through one and look at the corresponding position in the other.
-                uint32_t startOfData = sizeof(Header) + header.hashOffset + header.fileCount * sizeof(uint64_t);
+                const uint64_t fileRecordsSize = (sizeof(FileRecord) + sizeof(uint32_t)) * uint64_t(header.fileCount);
+                if (header.hashOffset < fileRecordsSize)
+                    throw error(LIBBSA_ERROR_PARSE_FAIL, "Structure of \"" + path.string() + "\" is invalid.");
+
+                fileCount = header.fileCount;
+                filenameRecordsSize = header.hashOffset - fileRecordsSize;
+                fileRecords = ReadBytes(sizeof(Header), header.hashOffset + sizeof(uint64_t) * uint64_t(header.fileCount), recordsBuffer);
+                filenameOffsets = fileRecords + sizeof(FileRecord) * header.fileCount;
+                filenameRecords = reinterpret_cast<const char*>(filenameOffsets + sizeof(uint32_t) * header.fileCount);
+                hashRecords = fileRecords + header.hashOffset;
+                startOfData = sizeof(Header) + header.hashOffset + header.fileCount * sizeof(uint64_t);
+
+                //If the last filename is null-terminated, all filenames that start inside the records are.
+                if (header.fileCount > 0 && (filenameRecordsSize == 0 || filenameRecords[filenameRecordsSize - 1] != '\0'))
+                    throw error(LIBBSA_ERROR_PARSE_FAIL, "Structure of \"" + path.string() + "\" is invalid.");
+
+                //All three arrays have the same ordering, so check them together.
                 for (uint32_t i = 0; i < header.fileCount; i++) {
-                    BsaAsset fileData;
-                    fileData.size = fileRecords[i].size;
-                    fileData.offset = startOfData + fileRecords[i].offset;  //Internally, offsets are adjusted so that they're from file beginning.
-                    fileData.hash = hashRecords[i];
-
-                    //Now we need to build the file path. First: file name.
-                    //Find position of null pointer.
-                    char * nptr = strchr((char*)(filenameRecords + filenameOffsets[i]), '\0');
-                    if (nptr == NULL)
+                    if (GetFilenameOffset(i) >= filenameRecordsSize)
                         throw error(LIBBSA_ERROR_PARSE_FAIL, "Structure of \"" + path.string() + "\" is invalid.");
 
-                    fileData.path = ToUTF8(string((char*)(filenameRecords + filenameOffsets[i]), nptr - (char*)(filenameRecords + filenameOffsets[i])));
-
-                    //Finally, add fileData to list.
-                    assets.push_back(fileData);
+                    if (i > 0 && hash_less(GetHash(i), GetHash(i - 1)))
+                        hashesSorted = false;
                 }
 
                 hashOffset = header.hashOffset;
 
-                delete[] fileRecords;
-                delete[] filenameOffsets;
-                delete[] filenameRecords;
-                delete[] hashRecords;
+                //Asset paths are decoded the first time they're all needed.
+                recordsSize = startOfData;
+                assetsLoaded = false;
             }
         }
 
-        void BSA::Save(const boost::filesystem::path& path, const uint32_t version, const uint32_t compression) {
+        void BSA::Save(const boost::filesystem::path& path, const uint32_t version, const uint32_t compression, unsigned int) {
             //Version and compression have been validated.
 
-            boost::filesystem::ifstream in(filePath, ios::binary);
-            in.exceptions(ios::failbit | ios::badbit | ios::eofbit);  //Causes ifstream::failure to be thrown if problem is encountered.
+            if (!fs::exists(filePath))
+                throw error(LIBBSA_ERROR_FILESYSTEM_ERROR, filePath.string() + " no longer exists");
+
+            RequireAssets();
 
             boost::filesystem::ofstream out(path, ios::binary | ios::trunc);
             out.exceptions(ios::failbit | ios::badbit | ios::eofbit);  //Causes ifstream::failure to be thrown if problem is encountered.
@@ -137,11 +126,12 @@ namespace libbsa {
 
             //Need to update the file data offsets before populating the records. This requires the list to be sorted by path.
             //We still want to keep the old offsets for writing the raw file data though.
-            assets.sort(path_comp);
+            vector<BsaAsset> sortedAssets = assets.ToVector();
+            stable_sort(begin(sortedAssets), end(sortedAssets), path_comp);
             uint32_t fileDataOffset = 0;
             vector<uint32_t> oldOffsets;
             boost::filesystem::ofstream debug(fs::path("debug.txt"));
-            for (list<BsaAsset>::iterator it = assets.begin(), endIt = assets.end(); it != endIt; ++it) {
+            for (vector<BsaAsset>::iterator it = sortedAssets.begin(), endIt = sortedAssets.end(); it != endIt; ++it) {
                 uint32_t offset = it->offset - (hashOffset + sizeof(Header) + header.fileCount * sizeof(uint64_t));
                 if (offset != fileDataOffset)
                     debug << it->path << '\t' << offset << '\t' << fileDataOffset << '\t' << int(offset - fileDataOffset) << endl;
@@ -154,10 +144,10 @@ namespace libbsa {
             debug.close();
 
                     //file data, names and hashes are all done in hash order, so sort list by hash.
-            assets.sort(hash_comp);
+            stable_sort(begin(sortedAssets), end(sortedAssets), hash_comp);
             uint32_t filenameOffset = 0;
             uint32_t i = 0;
-            for (list<BsaAsset>::const_iterator it = assets.begin(), endIt = assets.end(); it != endIt; ++it) {
+            for (vector<BsaAsset>::const_iterator it = sortedAssets.begin(), endIt = sortedAssets.end(); it != endIt; ++it) {
                 //Set size and offset.
                 fileRecords[i].size = it->size;
                 fileRecords[i].offset = it->offset;
@@ -192,39 +182,17 @@ namespace libbsa {
             delete[] hashes;
 
             //Now write out raw file data in alphabetical filename order.
-            assets.sort(path_comp);
-            i = 0;
-            for (list<BsaAsset>::const_iterator it = assets.begin(), endIt = assets.end(); it != endIt; ++it) {
-                //it->second.offset is the offset for the data in the new file. We don't need it though, because we're doing writes in sequence.
+            //This doesn't yet support assets that have been added to the BSA.
+            stable_sort(begin(sortedAssets), end(sortedAssets), path_comp);
+            vector<BsaAsset> sourceAssets(sortedAssets);
+            for (i = 0; i < sourceAssets.size(); i++) {
                 //We want the offset for the data in the old file.
-                //This doesn't yet support assets that have been added to the BSA.
-
-                //Allocate memory for this file's data, read it in, write it out, then free memory.
-                uint8_t * fileData;
-                try {
-                    fileData = new uint8_t[it->size];  //Doesn't matter where we get size from.
-                }
-                catch (bad_alloc& e) {
-                    throw error(LIBBSA_ERROR_NO_MEM, e.what());
-                }
-
-                //Read data in.
-                in.seekg(oldOffsets[i], ios_base::beg);
-                in.read((char*)fileData, it->size);
-
-                //Write data out.
-                out.write((char*)fileData, it->size);
-
-                //Free memory.
-                delete[] fileData;
-
-                i++;
+                sourceAssets[i].offset = oldOffsets[i];
             }
+            CopyStoredData(sourceAssets, out);
 
-            //Update member vars.
-            hashOffset = header.hashOffset;
+            //The handle still refers to the opened BSA, so its member vars are left unchanged.
 
-            in.close();
             out.close();
 
             //Now rename the output file.
@@ -237,28 +205,10 @@ namespace libbsa {
             }*/
         }
 
-        std::pair<uint8_t*, size_t> BSA::ReadData(std::ifstream& in, const BsaAsset& data) const {
-            //Just need to use size and offset to write to binary file stream.
-            uint8_t * buffer;
-
-            try {
-                buffer = new uint8_t[data.size];
-            }
-            catch (bad_alloc& e) {
-                throw error(LIBBSA_ERROR_NO_MEM, e.what());
-            }
-
-            in.seekg(data.offset, ios_base::beg);
-            in.read((char*)buffer, data.size);
-
-            return pair<uint8_t*, size_t>(buffer, data.size);
-        }
-
-        uint64_t BSA::CalcHash(const std::string& path) {
-            size_t len = path.length();
+        uint64_t BSA::CalcHash(const char * path, size_t len) {
             uint32_t hash1 = 0;
             uint32_t hash2 = 0;
-            unsigned l = path.length() >> 1;
+            unsigned l = len >> 1;
             unsigned sum, off, temp, i, n;
 
             for (sum = off = i = 0; i < l; i++) {
@@ -280,40 +230,141 @@ namespace libbsa {
         }
 
         bool BSA::hash_comp(const BsaAsset& first, const BsaAsset& second) {
-            //Data losses are intentional.
-            uint32_t f1 = first.hash;
-            uint32_t f2 = first.hash >> 32;
-            uint32_t s1 = second.hash;
-            uint32_t s2 = second.hash >> 32;
-
-            if (f1 < s1)
+            if (hash_less(first.hash, second.hash))
                 return true;
-            else if (f1 > s1)
-                return false;
-            else if (f2 < s2)
-                return true;
-            else if (f2 > s2)
+            else if (hash_less(second.hash, first.hash))
                 return false;
 
             return first.path < second.path;
         }
 
+        bool BSA::hash_less(uint64_t first, uint64_t second) {
+            //Data losses are intentional.
+            uint32_t f1 = first;
+            uint32_t f2 = first >> 32;
+            uint32_t s1 = second;
+            uint32_t s2 = second >> 32;
+
+            if (f1 != s1)
+                return f1 < s1;
+
+            return f2 < s2;
+        }
+
         bool BSA::path_comp(const BsaAsset& first, const BsaAsset& second) {
             return first.path < second.path;
         }
 
-        //Check if a given file is a Tes3-type BSA.
-        bool BSA::IsBSA(const boost::filesystem::path& path) {
-            //Check if file exists.
-            if (!fs::exists(path))
+        bool BSA::FindAsset(const std::string& normalisedPath, BsaAsset * asset) const {
+            if (assetsLoaded)
+                return GenericBsa::FindAsset(normalisedPath, asset);
+
+            //Compare against the stored names, which are in Windows-1252. The
+            //path is transcoded into a per-thread buffer, so lookups don't
+            //allocate once it's big enough.
+            static thread_local string assetPath;
+            try {
+                FromUTF8(normalisedPath, assetPath);
+            }
+            catch (error&) {
+                //The path can't be in the BSA.
                 return false;
+            }
+
+            //Checks if the given file has the path being looked up.
+            auto matchFile = [&](uint32_t index) {
+                const char * name = filenameRecords + GetFilenameOffset(index);
+                if (!NameEquals(name, strlen(name), assetPath.data(), assetPath.length()))
+                    return false;
+
+                if (asset != NULL)
+                    *asset = MakeAsset(index);
+
+                return true;
+            };
+
+            if (hashesSorted) {
+                //Binary search the hashes, only comparing names for hashes that match.
+                const uint64_t hash = CalcHash(assetPath.data(), assetPath.length());
+                uint32_t low = 0;
+                uint32_t high = fileCount;
+                while (low < high) {
+                    uint32_t mid = low + (high - low) / 2;
+                    if (hash_less(GetHash(mid), hash))
+                        low = mid + 1;
+                    else
+                        high = mid;
+                }
+
+                for (uint32_t i = low; i < fileCount && GetHash(i) == hash; i++) {
+                    if (matchFile(i))
+                        return true;
+                }
+
+                //Tools disagree on how to hash some paths (eg. ones with
+                //non-ASCII characters), so fall back to comparing names,
+                //which is what lookups do once the assets are loaded.
+            }
+
+            for (uint32_t i = 0; i < fileCount; i++) {
+                if (matchFile(i))
+                    return true;
+            }
 
-            boost::filesystem::ifstream in(path, ios::binary);
-            in.exceptions(ios::failbit | ios::badbit | ios::eofbit);
+            return false;
+        }
+
+        void BSA::LoadAssets() {
+            //Build the assets separately so that a failure leaves nothing half-loaded.
+            AssetTable loadedAssets;
+            loadedAssets.reserve(fileCount, filenameRecordsSize);
+            for (uint32_t i = 0; i < fileCount; i++) {
+                BsaAsset asset = MakeAsset(i);
+                loadedAssets.AddAsset(asset.path, asset.hash, asset.size, asset.offset);
+            }
+
+            assets.swap(loadedAssets);
+            BuildAssetIndex();
+        }
+
+        uint32_t BSA::GetFilenameOffset(uint32_t index) const {
+            uint32_t filenameOffset;
+            memcpy(&filenameOffset, filenameOffsets + index * sizeof(uint32_t), sizeof(uint32_t));
+
+            return filenameOffset;
+        }
+
+        uint64_t BSA::GetHash(uint32_t index) const {
+            uint64_t hash;
+            memcpy(&hash, hashRecords + index * sizeof(uint64_t), sizeof(uint64_t));
+
+            return hash;
+        }
+
+        BsaAsset BSA::MakeAsset(uint32_t index) const {
+            FileRecord fileRecord;
+            memcpy(&fileRecord, fileRecords + index * sizeof(FileRecord), sizeof(FileRecord));
+
+            BsaAsset fileData;
+            fileData.size = fileRecord.size;
+            fileData.offset = startOfData + fileRecord.offset;  //Internally, offsets are adjusted so that they're from file beginning.
+            fileData.hash = GetHash(index);
+            fileData.path = ToUTF8(filenameRecords + GetFilenameOffset(index));
+
+            return fileData;
+        }
+
+        //Check if a given file is a Tes3-type BSA.
+        bool BSA::IsBSA(const ArchiveFile& archiveFile) {
+            //Check if file exists and is big enough to have a header.
+            if (!archiveFile.IsOpen() || archiveFile.GetSize() < sizeof(uint32_t))
+                return false;
 
             uint32_t magic;
-            in.read((char*)&magic, sizeof(uint32_t));
-            in.close();
+            if (archiveFile.GetMapping() != NULL)
+                memcpy(&magic, archiveFile.GetMapping(), sizeof(uint32_t));
+            else
+                archiveFile.Read(0, sizeof(uint32_t), reinterpret_cast<uint8_t*>(&magic));
 
             return magic == VERSION;
         }
@@ -43,24 +43,54 @@ namespace libbsa {
         public:
             static const uint32_t VERSION = 0x100;
 
-            BSA(const boost::filesystem::path& path);
+            BSA(const boost::filesystem::path& path, ArchiveFile&& archiveFile);
             void Save(const boost::filesystem::path& path,
                       const uint32_t version,
-                      const uint32_t compression);
+                      const uint32_t compression,
+                      unsigned int threadCount);
 
             //Check if a given file is a Tes3-type BSA.
-            static bool IsBSA(const boost::filesystem::path& path);
+            static bool IsBSA(const ArchiveFile& archiveFile);
         private:
-            std::pair<uint8_t*, size_t> ReadData(std::ifstream& in,
-                                                 const BsaAsset& data) const;
+            bool FindAsset(const std::string& normalisedPath,
+                           BsaAsset * asset) const;
+            void LoadAssets();
 
-            static uint64_t CalcHash(const std::string& assetPath);
+            static uint64_t CalcHash(const char * path, size_t length);
 
             uint32_t hashOffset;
 
             static bool hash_comp(const BsaAsset& first, const BsaAsset& second);
             static bool path_comp(const BsaAsset& first, const BsaAsset& second);
 
+            // Compares hashes in the order they're stored, which is by their
+            // low 32 bits, then their high 32 bits.
+            static bool hash_less(uint64_t first, uint64_t second);
+
+            // Asset paths are only decoded when they're needed, so the BSA's
+            // records are kept. They point into the memory-mapped BSA, or into
+            // recordsBuffer if it isn't mapped. File records, filename
+            // offsets and hashes all have the same ordering.
+            std::vector<uint8_t> recordsBuffer;
+            uint32_t fileCount;
+            const uint8_t * fileRecords;
+            const uint8_t * filenameOffsets;
+            const char * filenameRecords;
+            uint32_t filenameRecordsSize;
+            const uint8_t * hashRecords;
+            uint32_t startOfData;
+
+            // Records are sorted by hash, so lookups can binary search the
+            // hashes. If a BSA's records aren't sorted, or a path's hash isn't
+            // found, lookups fall back to comparing names.
+            bool hashesSorted;
+
+            uint32_t GetFilenameOffset(uint32_t index) const;
+            uint64_t GetHash(uint32_t index) const;
+
+            // Builds the asset for the given record.
+            BsaAsset MakeAsset(uint32_t index) const;
+
             struct Header {
                 uint32_t version;
                 uint32_t hashOffset;
@@ -22,8 +22,16 @@
 */
 
 #include "tes4bsa.h"
+#include "asset_path.h"
 #include "error.h"
+#include "inflater.h"
 #include "libbsa/libbsa.h"
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
 #include <cstring>
 #include <boost/filesystem.hpp>
@@ -35,16 +43,15 @@ using namespace std;
 
 namespace libbsa {
     namespace tes4 {
-        BSA::BSA(const boost::filesystem::path& path) :
-            GenericBsa(path),
+        BSA::BSA(const boost::filesystem::path& path, ArchiveFile&& archiveFile) :
+            GenericBsa(path, std::move(archiveFile)),
             archiveFlags(0),
-            fileFlags(0) {
-            boost::filesystem::ifstream in(path, ios::binary);
-            in.exceptions(ios::failbit | ios::badbit | ios::eofbit);
-
+            fileFlags(0),
+            fileRecords(NULL),
+            fileNames(NULL),
+            hashesSorted(true) {
             Header header;
-            in.seekg(0, ios_base::beg);
-            in.read((char*)&header, sizeof(Header));
+            memcpy(&header, ReadBytes(0, sizeof(Header), recordsBuffer), sizeof(Header));
 
             if ((header.version != BSA_VERSION_TES4 && header.version != BSA_VERSION_TES5) || header.offset != BSA_FOLDER_RECORD_OFFSET)
                 throw error(LIBBSA_ERROR_PARSE_FAIL, "Structure of \"" + path.string() + "\" is invalid.");
@@ -52,80 +59,85 @@ namespace libbsa {
             //Now we get to the real meat of the file.
             //Folder records are followed by file records in blocks by folder name, followed by file names.
             //File records and file names have the same ordering.
+            //They're contiguous, so get them all at once, and keep them so that assets can be looked up without decoding every path.
             vector<FolderRecord> folderRecords(header.folderCount);
-            uint8_t * fileRecords;
-            uint8_t * fileNames;    //A list of null-terminated filenames, one after another.
-            uint32_t fileRecordsSize =
-                header.folderCount + //Folder name string length (in 1 byte).
+            const uint64_t fileRecordsSize =
+                uint64_t(header.folderCount) + //Folder name string length (in 1 byte).
                 header.totalFolderNameLength + //Total length of folder name strings.
-                sizeof(FileRecord) * header.fileCount;  //Total size of all file records.
-            try {
-                in.read(reinterpret_cast<char*>(&folderRecords[0]), sizeof(FolderRecord) * header.folderCount);
-
-                fileRecords = new uint8_t[fileRecordsSize];
-                in.read(reinterpret_cast<char*>(fileRecords), sizeof(uint8_t) * fileRecordsSize);
-
-                fileNames = new uint8_t[header.totalFileNameLength];
-                in.read(reinterpret_cast<char*>(fileNames), sizeof(uint8_t) * header.totalFileNameLength);
-            }
-            catch (bad_alloc& e) {
-                throw error(LIBBSA_ERROR_NO_MEM, e.what());
-            }
-
-            in.close(); //No longer need the file open.
-
-            /* Loop through the folder records, for each folder looking up the file records associated with it,
+                sizeof(FileRecord) * uint64_t(header.fileCount);  //Total size of all file records.
+            const uint8_t * records = ReadBytes(sizeof(Header),
+                                                sizeof(FolderRecord) * uint64_t(header.folderCount) + fileRecordsSize + header.totalFileNameLength,
+                                                recordsBuffer);
+            if (header.folderCount > 0)
+                memcpy(&folderRecords[0], records, sizeof(FolderRecord) * header.folderCount);
+            fileRecords = records + sizeof(FolderRecord) * header.folderCount;
+            fileNames = reinterpret_cast<const char*>(fileRecords + fileRecordsSize);    //A list of null-terminated filenames, one after another.
+
+            /* Loop through the folder records, for each folder finding its name and file records,
             and the filenames associated with those records. */
             uint32_t fileNameListPos = 0;
             const uint32_t folderRecordOffsetBaseline = sizeof(Header)
                 + sizeof(FolderRecord) * header.folderCount
                 + header.totalFileNameLength;
+            folders.reserve(header.folderCount);
+            fileNameOffsets.reserve(header.fileCount);
             for (auto& folderRecord : folderRecords) {
                 folderRecord.offset -= folderRecordOffsetBaseline;
+                if (folderRecord.offset >= fileRecordsSize)
+                    throw error(LIBBSA_ERROR_PARSE_FAIL, "Structure of \"" + path.string() + "\" is invalid.");
 
-                //Need to get folder name to add before file name in internal data store.
-                string folderName = getFolderName(fileRecords, folderRecord.offset);
-
-                //Now loop through file records for this folder record.
-                uint32_t startOfFolderFileRecords = folderRecord.offset + folderName.length() + 2;
-                for (uint32_t i = 0; i < folderRecord.count; i++) {
-                    uint8_t * fileRecordOffset = fileRecords + startOfFolderFileRecords + i * sizeof(FileRecord);
-                    FileRecord fileRecord = *reinterpret_cast<FileRecord*>(fileRecordOffset);
-
-                    BsaAsset fileData;
-                    fileData.hash = fileRecord.nameHash;
-                    fileData.size = fileRecord.size;
-                    fileData.offset = fileRecord.offset;
+                //The folder name is prefixed by its length, which includes its null terminator.
+                Folder folder;
+                uint8_t folderNameLength = *(fileRecords + folderRecord.offset);
+                folder.name = reinterpret_cast<const char*>(fileRecords + folderRecord.offset + 1);
+                folder.nameLength = folderNameLength > 0 ? folderNameLength - 1 : 0;
+                folder.nameHash = folderRecord.nameHash;
+                folder.fileCount = folderRecord.count;
+                folder.fileRecordsOffset = folderRecord.offset + folderNameLength + 1;
+                folder.firstFile = fileNameOffsets.size();
+                if (uint64_t(folder.fileRecordsOffset) + uint64_t(folder.fileCount) * sizeof(FileRecord) > fileRecordsSize)
+                    throw error(LIBBSA_ERROR_PARSE_FAIL, "Structure of \"" + path.string() + "\" is invalid.");
 
-                    if (!folderName.empty())
-                        fileData.path = folderName + '\\';
+                //Find where each of the folder's file names start. The
+                //stored lengths are used, as they can differ from the
+                //lengths of the names once they're transcoded.
+                for (uint32_t i = 0; i < folder.fileCount; i++) {
+                    const char * nullTerminatorPos = fileNameListPos < header.totalFileNameLength
+                        ? static_cast<const char*>(memchr(fileNames + fileNameListPos, '\0', header.totalFileNameLength - fileNameListPos))
+                        : NULL;
+                    if (nullTerminatorPos == NULL)
+                        throw error(LIBBSA_ERROR_PARSE_FAIL, "Structure of \"" + path.string() + "\" is invalid.");
+
+                    fileNameOffsets.push_back(fileNameListPos);
+                    fileNameListPos = nullTerminatorPos - fileNames + 1;
+
+                    if (i > 0 && GetFileRecord(folder, i).nameHash < GetFileRecord(folder, i - 1).nameHash)
+                        hashesSorted = false;
+                }
 
-                    std::string filename = getFileName(fileNames, fileNameListPos);
-                    fileData.path += filename;
-                    fileNameListPos += filename.length() + 1;
+                if (!folders.empty() && folder.nameHash < folders.back().nameHash)
+                    hashesSorted = false;
 
-                    //Finally, store file data.
-                    assets.push_back(fileData);
-                }
+                folders.push_back(folder);
             }
 
             //Record the file and archive flags.
             fileFlags = header.fileFlags;
             archiveFlags = header.archiveFlags;
 
-            delete[] fileRecords;
-            delete[] fileNames;
+            //Asset paths are decoded the first time they're all needed.
+            recordsSize = sizeof(Header) + sizeof(FolderRecord) * uint64_t(header.folderCount) + fileRecordsSize + header.totalFileNameLength;
+            assetsLoaded = false;
         }
 
-        void BSA::Save(const boost::filesystem::path& path, const uint32_t version, const uint32_t compression) {
+        void BSA::Save(const boost::filesystem::path& path, const uint32_t version, const uint32_t compression, unsigned int threadCount) {
             if (fs::exists(path))
                 throw error(LIBBSA_ERROR_INVALID_ARGS, path.string() + " already exists");
 
             if (!fs::exists(filePath))
                 throw error(LIBBSA_ERROR_FILESYSTEM_ERROR, filePath.string() + " no longer exists");
 
-            boost::filesystem::ifstream in(filePath, ios::binary);
-            in.exceptions(ios::failbit | ios::badbit | ios::eofbit);  //Causes ifstream::failure to be thrown if problem is encountered.
+            RequireAssets();
 
             boost::filesystem::ofstream out(path, ios::binary | ios::trunc);
             out.exceptions(ios::failbit | ios::badbit | ios::eofbit);  //Causes ifstream::failure to be thrown if problem is encountered.
@@ -153,40 +165,50 @@ namespace libbsa {
                     header.archiveFlags |= BSA_COMPRESSED;
             }
 
-            //Need to sort folder and file names separately into hash-sorted sets before header.folderCount and name lengths can be set.
-            list<BsaAsset> folderHashset;
-            list<BsaAsset> fileHashset;
-            for (auto it = assets.begin(), endIt = assets.end(); it != endIt; ++it) {
-                BsaAsset folderAsset;
-                BsaAsset fileAsset;
+            //Files are grouped by folder, with folders and the files in each folder sorted by hash.
+            //Paths are split and transcoded once, then the sorted list is walked in a single pass.
+            const vector<BsaAsset> currentAssets = assets.ToVector();
+            vector<SaveEntry> entries;
+            entries.reserve(currentAssets.size());
+            string normalisedFolderName;
+            for (auto it = currentAssets.begin(), endIt = currentAssets.end(); it != endIt; ++it) {
+                SaveEntry entry;
+                entry.asset = &*it;
 
                 //Transcode paths.
-                folderAsset.path = FromUTF8(fs::path(it->path).parent_path().string());
-                fileAsset.path = FromUTF8(it->path); /*fs::path(it->path).filename().string();*/
-
-                folderAsset.hash = CalcHash(folderAsset.path, "");
-                fileAsset.hash = it->hash;
+                string assetPath = FromUTF8(it->path);
+                size_t pos = assetPath.rfind('\\');
+                if (pos != string::npos) {
+                    entry.folderName = assetPath.substr(0, pos);
+                    entry.fileName = assetPath.substr(pos + 1);
+                }
+                else
+                    entry.fileName = assetPath;
 
-                fileAsset.size = it->size;
-                fileAsset.offset = it->offset;
+                //Hash the folder name the same way that lookups do.
+                libbsa::NormaliseAssetPath(entry.folderName.data(), entry.folderName.length(), normalisedFolderName);
+                entry.folderHash = CalcHash(normalisedFolderName.data(), normalisedFolderName.length(), "", 0);
 
-                folderHashset.push_back(folderAsset);  //Size and offset are zero for now.
-                fileHashset.push_back(fileAsset);
+                entries.push_back(entry);
             }
-            folderHashset.unique(path_comp);
-            fileHashset.unique(path_comp);
-            header.folderCount = folderHashset.size();
-
-            header.fileCount = assets.size();
-
+            stable_sort(begin(entries), end(entries), [](const SaveEntry& first, const SaveEntry& second) {
+                if (first.folderHash != second.folderHash)
+                    return first.folderHash < second.folderHash;
+                if (first.folderName != second.folderName)
+                    return first.folderName < second.folderName;
+                return first.asset->hash < second.asset->hash;
+            });
+
+            header.folderCount = 0;
+            header.fileCount = entries.size();
             header.totalFolderNameLength = 0;
-            for (list<BsaAsset>::iterator it = folderHashset.begin(), endIt = folderHashset.end(); it != endIt; ++it) {
-                header.totalFolderNameLength += it->path.length() + 1;
-            }
-
             header.totalFileNameLength = 0;
-            for (list<BsaAsset>::iterator it = fileHashset.begin(), endIt = fileHashset.end(); it != endIt; ++it) {
-                header.totalFileNameLength += fs::path(it->path).filename().string().length() + 1;
+            for (size_t i = 0; i < entries.size(); ++i) {
+                if (i == 0 || entries[i].folderName != entries[i - 1].folderName) {
+                    header.folderCount++;
+                    header.totalFolderNameLength += entries[i].folderName.length() + 1;
+                }
+                header.totalFileNameLength += entries[i].fileName.length() + 1;
             }
 
             header.fileFlags = fileFlags;
@@ -195,11 +217,9 @@ namespace libbsa {
             // Set folder record array
             /////////////////////////////
 
-            /* Iterate through the folder hashmap.
-               For each folder, scan the file hashmap for files with matching parent paths.
-               For any such files, write out their nameHash, size and the offset at which their data can be found (calculated from the sum of previous sizes).
-               Also prepend the length of the folder name and the folder name to this file data list.
-               Once all matching files have been found, add their count and offset to the folder record stream.
+            /* Walk through the sorted entries.
+               At the start of each folder, write out its name length and name, and start a new folder record.
+               For each file, write out its nameHash, size and the offset at which its data can be found (calculated from the sum of previous sizes).
             */
 
             FolderRecord * folderRecords;
@@ -217,51 +237,48 @@ namespace libbsa {
 
             uint32_t startOfFileRecordBlock = sizeof(Header) + header.folderCount * sizeof(FolderRecord) + header.totalFileNameLength;  //For some reason offsets include this.
             uint32_t fileDataOffset = startOfFileRecordBlock + fileRecordBlocksSize;
-            list<BsaAsset> orderedAssets;
-            uint32_t i = 0;
+            vector<BsaAsset> sourceAssets;
+            vector<uint32_t> recordPositions;
+            sourceAssets.reserve(entries.size());
+            recordPositions.reserve(entries.size());
+            int32_t i = -1;
             uint32_t currFileRecordBlockPos = 0;
             uint32_t currFileNamePos = 0;
-            folderHashset.sort(hash_comp);
-            fileHashset.sort(hash_comp);
-            for (list<BsaAsset>::iterator it = folderHashset.begin(), endIt = folderHashset.end(); it != endIt; ++it) {
-                //Write folder hash and offset, write count later.
-                folderRecords[i].nameHash = it->hash;
-                folderRecords[i].offset = startOfFileRecordBlock + currFileRecordBlockPos;
-
-                //Write folder name length, folder name to fileRecordBlocks buffer.
-                size_t fileCount = 0;
-                uint8_t nameLength = it->path.length() + 1;
-                fileRecordBlocks[currFileRecordBlockPos] = nameLength;
-                currFileRecordBlockPos++;
-                strcpy((char*)fileRecordBlocks + currFileRecordBlockPos, (it->path + '\0').data());
-                currFileRecordBlockPos += nameLength;
-
-                uint32_t j = 0;
-                for (list<BsaAsset>::iterator itr = fileHashset.begin(), endItr = fileHashset.end(); itr != endItr; ++itr) {
-                    if (fs::path(itr->path).parent_path().string() == it->path) {
-                        //Write file hash, size and offset to fileRecordBlocks stream.
-                        memcpy(fileRecordBlocks + currFileRecordBlockPos, &(itr->hash), sizeof(uint64_t));
-                        currFileRecordBlockPos += sizeof(uint64_t);
-                        memcpy(fileRecordBlocks + currFileRecordBlockPos, &(itr->size), sizeof(uint32_t));
-                        currFileRecordBlockPos += sizeof(uint32_t);
-                        memcpy(fileRecordBlocks + currFileRecordBlockPos, &fileDataOffset, sizeof(uint32_t));
-                        currFileRecordBlockPos += sizeof(uint32_t);
-                        //Increment count and data offset.
-                        fileCount++;
-                        fileDataOffset += itr->size;
-                        //Add record data to list for later ordered extraction.
-                        orderedAssets.push_back(*itr);
-                        orderedAssets.back().offset = fileDataOffset;  //Can't update the offset in the set.
-                        //Also write out filename to fileNameBlock.
-                        string filename = fs::path(itr->path).filename().string() + '\0';
-                        strcpy((char*)fileNames + currFileNamePos, filename.data());
-                        currFileNamePos += filename.length();
-                    }
+            for (size_t j = 0; j < entries.size(); ++j) {
+                const SaveEntry& entry = entries[j];
+
+                if (j == 0 || entry.folderName != entries[j - 1].folderName) {
+                    //Write folder hash and offset, count files as they're written.
+                    i++;
+                    folderRecords[i].nameHash = entry.folderHash;
+                    folderRecords[i].offset = startOfFileRecordBlock + currFileRecordBlockPos;
+                    folderRecords[i].count = 0;
+
+                    //Write folder name length, folder name to fileRecordBlocks buffer.
+                    uint8_t nameLength = entry.folderName.length() + 1;
+                    fileRecordBlocks[currFileRecordBlockPos] = nameLength;
+                    currFileRecordBlockPos++;
+                    memcpy(fileRecordBlocks + currFileRecordBlockPos, entry.folderName.c_str(), nameLength);
+                    currFileRecordBlockPos += nameLength;
                 }
 
-                folderRecords[i].count = fileCount;
-
-                i++;
+                recordPositions.push_back(currFileRecordBlockPos);
+
+                //Write file hash, size and offset to fileRecordBlocks stream.
+                memcpy(fileRecordBlocks + currFileRecordBlockPos, &(entry.asset->hash), sizeof(uint64_t));
+                currFileRecordBlockPos += sizeof(uint64_t);
+                memcpy(fileRecordBlocks + currFileRecordBlockPos, &(entry.asset->size), sizeof(uint32_t));
+                currFileRecordBlockPos += sizeof(uint32_t);
+                memcpy(fileRecordBlocks + currFileRecordBlockPos, &fileDataOffset, sizeof(uint32_t));
+                currFileRecordBlockPos += sizeof(uint32_t);
+                //Increment count and data offset.
+                folderRecords[i].count++;
+                fileDataOffset += GetStoredSize(*entry.asset);
+                //Keep the old BSA's asset data for writing out file data in the same order.
+                sourceAssets.push_back(*entry.asset);
+                //Also write out filename to fileNameBlock.
+                memcpy(fileNames + currFileNamePos, entry.fileName.c_str(), entry.fileName.length() + 1);
+                currFileNamePos += entry.fileName.length() + 1;
             }
 
             ////////////////////////
@@ -274,55 +291,49 @@ namespace libbsa {
             out.write((char*)fileNames, header.totalFileNameLength);
 
             delete[] folderRecords;
-            delete[] fileRecordBlocks;
             delete[] fileNames;
 
-            //Now write out raw file data in the same order it was listed in the FileRecordBlocks.
-            for (list<BsaAsset>::iterator it = orderedAssets.begin(), endIt = orderedAssets.end(); it != endIt; ++it) {
-                //Allocate memory for this file's data, read it in, write it out, then free memory.
-                //This doesn't yet support compression level changing or assets that have been added to the BSA.
+            if (compression == LIBBSA_COMPRESS_LEVEL_NOCHANGE) {
+                delete[] fileRecordBlocks;
 
-                uint32_t size = it->size;
-                if (size & FILE_INVERT_COMPRESSED)  //Remove compression flag from size to get actual size.
-                    size ^= FILE_INVERT_COMPRESSED;
+                //Now write out raw file data unchanged, in the same order it was listed in the FileRecordBlocks.
+                //This doesn't yet support assets that have been added to the BSA.
+                CopyStoredData(sourceAssets, out);
+            }
+            else {
+                //The data's size changes when it's recompressed, so write it
+                //out first, then go back and fill in the file records.
+                int compressionLevel = -1;
+                if (header.archiveFlags & BSA_COMPRESSED) {
+                    compressionLevel = 1;
+                    for (uint32_t flag = LIBBSA_COMPRESS_LEVEL_1; flag < compression; flag <<= 1)
+                        compressionLevel++;
+                }
 
-                uint8_t * fileData;
                 try {
-                    fileData = new uint8_t[size];
-                }
-                catch (bad_alloc& e) {
-                    throw error(LIBBSA_ERROR_NO_MEM, e.what());
+                    uint32_t dataOffset = startOfFileRecordBlock + fileRecordBlocksSize;
+                    TranscodeAssets(sourceAssets, compressionLevel, threadCount, [&](size_t index, const vector<uint8_t>& data) {
+                        out.write((const char*)data.data(), data.size());
+
+                        //All files now match the archive's compression, so no invert flags are needed.
+                        uint32_t size = data.size();
+                        memcpy(fileRecordBlocks + recordPositions[index] + sizeof(uint64_t), &size, sizeof(uint32_t));
+                        memcpy(fileRecordBlocks + recordPositions[index] + sizeof(uint64_t) + sizeof(uint32_t), &dataOffset, sizeof(uint32_t));
+                        dataOffset += size;
+                    });
+
+                    out.seekp(sizeof(Header) + sizeof(FolderRecord) * header.folderCount, ios_base::beg);
+                    out.write((char*)fileRecordBlocks, fileRecordBlocksSize);
                 }
-
-                //Get the old BSA's file data offset.
-                list<BsaAsset>::iterator itr, endItr;
-                for (itr = assets.begin(), endItr = assets.end(); itr != endItr; ++itr) {
-                    if (itr->path == it->path)
-                        break;
+                catch (...) {
+                    delete[] fileRecordBlocks;
+                    throw;
                 }
-
-                if (itr == endItr)
-                    throw error(LIBBSA_ERROR_PARSE_FAIL, "Structure of \"" + path.string() + "\" is invalid.");
-
-                //Read data in.
-                in.seekg(itr->offset, ios_base::beg);  //This is the offset in the old BSA.
-                in.read((char*)fileData, size);
-
-                //Write data out.
-                out.write((char*)fileData, size);
-
-                //Free memory.
-                delete[] fileData;
-
-                //Update the stored offset.
-                itr->offset = it->offset;
+                delete[] fileRecordBlocks;
             }
 
-            //Update member vars.
-            archiveFlags = header.archiveFlags;
-            fileFlags = header.fileFlags;
+            //The handle still refers to the opened BSA, so its member vars are left unchanged.
 
-            in.close();
             out.close();
 
             //Now rename the output file.
@@ -335,91 +346,402 @@ namespace libbsa {
             }*/
         }
 
-        std::pair<uint8_t*, size_t> BSA::ReadData(std::ifstream& in, const BsaAsset& data) const {
-            uint8_t * outBuffer = NULL;
-            uint32_t outSize = data.size;
-
+        uint32_t BSA::GetStoredSize(const BsaAsset& data) const {
             // Remove compression flag from size to get actual size.
-            if (outSize & FILE_INVERT_COMPRESSED)
-                outSize ^= FILE_INVERT_COMPRESSED;
+            return data.size & ~FILE_INVERT_COMPRESSED;
+        }
+
+        bool BSA::IsCompressed(const BsaAsset& data) const {
+            // The file's flag inverts the archive's default.
+            bool archiveCompressed = (archiveFlags & BSA_COMPRESSED) != 0;
+            bool invertCompressed = (data.size & FILE_INVERT_COMPRESSED) != 0;
+
+            return archiveCompressed != invertCompressed;
+        }
+
+        std::pair<uint8_t*, size_t> BSA::UncompressData(const BsaAsset& data,
+                                                        const uint8_t * storedData,
+                                                        size_t storedSize) const {
+            if (storedSize < sizeof(uint32_t))
+                throw error(LIBBSA_ERROR_ZLIB_ERROR, "Uncompressing of \"" + data.path + "\" failed.");
+
+            uint32_t originalSize;
+            memcpy(&originalSize, storedData, sizeof(uint32_t));
+            size_t uncompressedSize = originalSize;
+            storedData += sizeof(uint32_t);
+            storedSize -= sizeof(uint32_t);
 
+            uint8_t * uncompressedData;
             try {
-                outBuffer = new uint8_t[outSize];
+                uncompressedData = new uint8_t[uncompressedSize];
             }
             catch (bad_alloc& e) {
                 throw error(LIBBSA_ERROR_NO_MEM, e.what());
             }
 
-            in.seekg(data.offset, ios_base::beg);
-            in.read(reinterpret_cast<char*>(outBuffer), outSize);
+            // Whole-buffer inflation goes through the configured backend.
+            if (!InflateBuffer(storedData, storedSize, uncompressedData, uncompressedSize)) {
+                delete[] uncompressedData;
+                throw error(LIBBSA_ERROR_ZLIB_ERROR, "Uncompressing of \"" + data.path + "\" failed.");
+            }
+
+            return make_pair(uncompressedData, uncompressedSize);
+        }
+
+        void BSA::UncompressData(const BsaAsset& data,
+                                 const uint8_t * storedData,
+                                 size_t storedSize,
+                                 const ChunkHandler& handler) const {
+            if (storedSize < sizeof(uint32_t))
+                throw error(LIBBSA_ERROR_ZLIB_ERROR, "Uncompressing of \"" + data.path + "\" failed.");
+
+            uint32_t originalSize;
+            memcpy(&originalSize, storedData, sizeof(uint32_t));
+
+            z_stream stream;
+            stream.zalloc = Z_NULL;
+            stream.zfree = Z_NULL;
+            stream.opaque = Z_NULL;
+            stream.next_in = const_cast<Bytef*>(storedData + sizeof(uint32_t));
+            stream.avail_in = storedSize - sizeof(uint32_t);
+
+            if (inflateInit(&stream) != Z_OK)
+                throw error(LIBBSA_ERROR_ZLIB_ERROR, "Uncompressing of \"" + data.path + "\" failed.");
+
+            // Inflate into a fixed-size window, handing it off each time it
+            // fills, so memory use doesn't grow with the asset's size.
+            vector<uint8_t> chunk(ChunkSize);
+            uint64_t totalOut = 0;
+            int ret = Z_OK;
+            try {
+                while (ret != Z_STREAM_END) {
+                    stream.next_out = chunk.data();
+                    stream.avail_out = chunk.size();
 
-            // If file is compressed, need to uncompress it with zlib.
-            if ((archiveFlags & BSA_COMPRESSED) != (outSize & FILE_INVERT_COMPRESSED))
-                return uncompressData(data.path, outBuffer, outSize);
+                    ret = inflate(&stream, Z_NO_FLUSH);
+                    if (ret != Z_OK && ret != Z_STREAM_END)
+                        break;
+
+                    size_t have = chunk.size() - stream.avail_out;
+                    totalOut += have;
+                    if (totalOut > originalSize) {
+                        ret = Z_DATA_ERROR;
+                        break;
+                    }
+
+                    if (have > 0)
+                        handler(chunk.data(), have);
+                }
+            }
+            catch (...) {
+                inflateEnd(&stream);
+                throw;
+            }
+            inflateEnd(&stream);
 
-            return make_pair(outBuffer, outSize);
+            if (ret != Z_STREAM_END)
+                throw error(LIBBSA_ERROR_ZLIB_ERROR, "Uncompressing of \"" + data.path + "\" failed.");
         }
 
-        std::pair<uint8_t*, size_t> BSA::uncompressData(const std::string& assetPath,
-                                                        const uint8_t * data,
-                                                        size_t size) {
-            size_t uncompressedSize = *reinterpret_cast<const uint32_t*>(data);
-            data += sizeof(uint32_t);
-            size -= sizeof(uint32_t);
+        std::vector<uint8_t> BSA::TranscodeData(const BsaAsset& data, int compressionLevel) const {
+            vector<uint8_t> outData;
 
-            uint8_t * uncompressedData;
+            const uint32_t storedSize = GetStoredSize(data);
+            vector<uint8_t> buffer;
+
+            if (compressionLevel < 0 && !IsCompressed(data)) {
+                const uint8_t * storedData = ReadBytes(data.offset, storedSize, buffer);
+                outData.assign(storedData, storedData + storedSize);
+                return outData;
+            }
+
+            //Get the uncompressed data.
+            const uint8_t * uncompressedData;
+            size_t uncompressedSize;
+            unique_ptr<uint8_t[]> ownedData;
+            if (IsCompressed(data)) {
+                pair<uint8_t*, size_t> dataPair = ReadData(data);
+                ownedData.reset(dataPair.first);
+                uncompressedData = dataPair.first;
+                uncompressedSize = dataPair.second;
+            }
+            else {
+                uncompressedData = ReadBytes(data.offset, storedSize, buffer);
+                uncompressedSize = storedSize;
+            }
+
+            if (compressionLevel < 0) {
+                outData.assign(uncompressedData, uncompressedData + uncompressedSize);
+                return outData;
+            }
+
+            //Compressed data is prefixed by its uncompressed size.
+            uLongf compressedSize = compressBound(uncompressedSize);
             try {
-                uncompressedData = new uint8_t[uncompressedSize];
+                outData.resize(sizeof(uint32_t) + compressedSize);
             }
             catch (bad_alloc& e) {
                 throw error(LIBBSA_ERROR_NO_MEM, e.what());
             }
 
-            // We can use a pre-made utility function instead of having to mess around with zlib proper.
-            int ret = uncompress(uncompressedData, reinterpret_cast<uLongf*>(&uncompressedSize), data, size);
+            uint32_t originalSize = uncompressedSize;
+            memcpy(outData.data(), &originalSize, sizeof(uint32_t));
+
+            int ret = compress2(outData.data() + sizeof(uint32_t), &compressedSize, uncompressedData, uncompressedSize, compressionLevel);
             if (ret != Z_OK)
-                throw error(LIBBSA_ERROR_ZLIB_ERROR, "Uncompressing of \"" + assetPath + "\" failed.");
+                throw error(LIBBSA_ERROR_ZLIB_ERROR, "Compressing of \"" + data.path + "\" failed.");
 
-            // Free memory.
-            data -= sizeof(uint32_t);
-            delete[] data;
+            outData.resize(sizeof(uint32_t) + compressedSize);
 
-            return make_pair(uncompressedData, uncompressedSize);
+            return outData;
+        }
+
+        void BSA::TranscodeAssets(const std::vector<BsaAsset>& sourceAssets,
+                                  int compressionLevel,
+                                  unsigned int threadCount,
+                                  const std::function<void(size_t index, const std::vector<uint8_t>& data)>& writer) const {
+            // Workers transcode assets in parallel, while this thread writes
+            // their results out in order. Workers can get at most a few assets
+            // ahead of the writer, so memory use stays bounded.
+            const size_t workerCount = threadCount > 0 ? threadCount : max(thread::hardware_concurrency(), 1u);
+            const size_t maxPending = 2 * workerCount;
+
+            vector<vector<uint8_t>> results(sourceAssets.size());
+            vector<bool> isReady(sourceAssets.size(), false);
+            size_t nextJob = 0;
+            size_t nextWrite = 0;
+            bool failed = false;
+            exception_ptr firstError;
+            mutex resultsMutex;
+            condition_variable resultsChanged;
+
+            auto fail = [&](exception_ptr e) {
+                lock_guard<mutex> guard(resultsMutex);
+                if (!firstError)
+                    firstError = e;
+                failed = true;
+                resultsChanged.notify_all();
+            };
+
+            auto worker = [&]() {
+                while (true) {
+                    size_t i;
+                    {
+                        unique_lock<mutex> lock(resultsMutex);
+                        resultsChanged.wait(lock, [&]() {
+                            return failed || nextJob >= sourceAssets.size() || nextJob < nextWrite + maxPending;
+                        });
+                        if (failed || nextJob >= sourceAssets.size())
+                            return;
+                        i = nextJob++;
+                    }
+
+                    try {
+                        vector<uint8_t> data = TranscodeData(sourceAssets[i], compressionLevel);
+
+                        lock_guard<mutex> guard(resultsMutex);
+                        results[i].swap(data);
+                        isReady[i] = true;
+                        resultsChanged.notify_all();
+                    }
+                    catch (...) {
+                        fail(current_exception());
+                        return;
+                    }
+                }
+            };
+
+            // If a worker can't be started, the error is recorded like any
+            // other, and the workers that were started are still joined.
+            vector<thread> workers;
+            try {
+                for (size_t i = 0; i < workerCount; ++i)
+                    workers.emplace_back(worker);
+
+                for (size_t i = 0; i < sourceAssets.size(); ++i) {
+                    vector<uint8_t> data;
+                    {
+                        unique_lock<mutex> lock(resultsMutex);
+                        resultsChanged.wait(lock, [&]() { return failed || isReady[i]; });
+                        if (failed)
+                            break;
+                        data.swap(results[i]);
+                        nextWrite++;
+                        resultsChanged.notify_all();
+                    }
+
+                    writer(i, data);
+                }
+            }
+            catch (...) {
+                fail(current_exception());
+            }
+
+            for (auto& workerThread : workers)
+                workerThread.join();
+
+            if (firstError)
+                rethrow_exception(firstError);
+        }
+
+        bool BSA::FindAsset(const std::string& normalisedPath, BsaAsset * asset) const {
+            if (assetsLoaded)
+                return GenericBsa::FindAsset(normalisedPath, asset);
+
+            //Compare against the stored names, which are in Windows-1252. The
+            //path is transcoded into a per-thread buffer and the folder and
+            //file names are hashed and compared in place, so lookups don't
+            //allocate once the buffer is big enough.
+            static thread_local string path;
+            try {
+                FromUTF8(normalisedPath, path);
+            }
+            catch (error&) {
+                //The path can't be in the BSA.
+                return false;
+            }
+
+            const size_t separatorPos = path.rfind('\\');
+            const size_t fileNamePos = separatorPos == string::npos ? 0 : separatorPos + 1;
+            const char * folderName = path.data();
+            const size_t folderNameLength = separatorPos == string::npos ? 0 : separatorPos;
+            const char * fileName = path.data() + fileNamePos;
+            const size_t fileNameLength = path.length() - fileNamePos;
+
+            //Checks if the given file in the given folder has the file name being looked up.
+            auto matchFile = [&](const Folder& folder, uint32_t index) {
+                const char * name = fileNames + fileNameOffsets[folder.firstFile + index];
+                if (!NameEquals(name, strlen(name), fileName, fileNameLength))
+                    return false;
+
+                if (asset != NULL)
+                    *asset = MakeAsset(ToUTF8(string(folder.name, folder.nameLength)), folder, index);
+
+                return true;
+            };
+
+            if (hashesSorted) {
+                //Binary search the folder hashes, then the file hashes, only comparing names for hashes that match.
+                const uint64_t folderHash = CalcHash(folderName, folderNameLength, "", 0);
+
+                //The extension is hashed separately, and a name without one
+                //is hashed as if it had an empty extension.
+                size_t extPos = path.rfind('.');
+                if (extPos == string::npos || extPos < fileNamePos)
+                    extPos = path.length();
+                const uint64_t fileHash = CalcHash(fileName, extPos - fileNamePos, path.data() + extPos, path.length() - extPos);
+
+                auto folderIt = lower_bound(begin(folders), end(folders), folderHash, [](const Folder& folder, uint64_t hash) {
+                    return folder.nameHash < hash;
+                });
+                for (; folderIt != end(folders) && folderIt->nameHash == folderHash; ++folderIt) {
+                    if (!NameEquals(folderIt->name, folderIt->nameLength, folderName, folderNameLength))
+                        continue;
+
+                    uint32_t low = 0;
+                    uint32_t high = folderIt->fileCount;
+                    while (low < high) {
+                        uint32_t mid = low + (high - low) / 2;
+                        if (GetFileRecord(*folderIt, mid).nameHash < fileHash)
+                            low = mid + 1;
+                        else
+                            high = mid;
+                    }
+
+                    for (uint32_t i = low; i < folderIt->fileCount && GetFileRecord(*folderIt, i).nameHash == fileHash; i++) {
+                        if (matchFile(*folderIt, i))
+                            return true;
+                    }
+                }
+
+                //The stored hashes may not be what CalcHash gives (eg. older
+                //libbsa versions didn't normalise folder names before hashing
+                //them, and other tools differ too), so fall back to comparing
+                //names, which is what lookups do once the assets are loaded.
+            }
+
+            for (const auto& folder : folders) {
+                if (!NameEquals(folder.name, folder.nameLength, folderName, folderNameLength))
+                    continue;
+
+                for (uint32_t i = 0; i < folder.fileCount; i++) {
+                    if (matchFile(folder, i))
+                        return true;
+                }
+            }
+
+            return false;
+        }
+
+        void BSA::LoadAssets() {
+            //Names may get longer when transcoded, but usually don't.
+            size_t namesLength = 0;
+            for (const auto& folder : folders)
+                namesLength += folder.nameLength + 1;
+            if (!fileNameOffsets.empty())
+                namesLength += fileNameOffsets.back() + strlen(fileNames + fileNameOffsets.back());
+
+            //Build the assets separately so that a failure leaves nothing half-loaded.
+            AssetTable loadedAssets;
+            loadedAssets.reserve(fileNameOffsets.size(), namesLength);
+            for (const auto& folder : folders) {
+                uint32_t folderIndex = loadedAssets.AddFolder(ToUTF8(string(folder.name, folder.nameLength)));
+
+                for (uint32_t i = 0; i < folder.fileCount; i++) {
+                    FileRecord fileRecord = GetFileRecord(folder, i);
+                    loadedAssets.AddAsset(folderIndex,
+                                          ToUTF8(fileNames + fileNameOffsets[folder.firstFile + i]),
+                                          fileRecord.nameHash,
+                                          fileRecord.size,
+                                          fileRecord.offset);
+                }
+            }
+
+            assets.swap(loadedAssets);
+            BuildAssetIndex();
         }
 
-        std::string BSA::getFolderName(const uint8_t * fileRecords, uint32_t folderOffset) {
-            const char * folderName = reinterpret_cast<const char*>(fileRecords + folderOffset + 1);
-            uint8_t folderNameLength = *(fileRecords + folderOffset) - 1;
+        BSA::FileRecord BSA::GetFileRecord(const Folder& folder, uint32_t index) const {
+            FileRecord fileRecord;
+            memcpy(&fileRecord, fileRecords + folder.fileRecordsOffset + index * sizeof(FileRecord), sizeof(FileRecord));
 
-            return ToUTF8(string(folderName, folderNameLength));
+            return fileRecord;
         }
 
-        std::string BSA::getFileName(const uint8_t * fileNames, uint32_t offset) {
-            const char * filename = reinterpret_cast<const char*>(fileNames + offset);
+        BsaAsset BSA::MakeAsset(const std::string& folderName, const Folder& folder, uint32_t index) const {
+            FileRecord fileRecord = GetFileRecord(folder, index);
+
+            BsaAsset fileData;
+            fileData.hash = fileRecord.nameHash;
+            fileData.size = fileRecord.size;
+            fileData.offset = fileRecord.offset;
 
-            //Find position of null character.
-            char * nullTerminatorPos = strchr(const_cast<char*>(filename), '\0');
-            if (nullTerminatorPos == NULL)
-                throw error(LIBBSA_ERROR_PARSE_FAIL, "String at " + to_string(*(size_t*)filename) + "is not null terminated.");
+            if (!folderName.empty())
+                fileData.path = folderName + '\\';
 
-            return ToUTF8(string(filename, nullTerminatorPos - filename));
+            fileData.path += ToUTF8(fileNames + fileNameOffsets[folder.firstFile + index]);
+
+            return fileData;
         }
 
-        uint32_t BSA::HashString(const std::string& str) {
+        uint32_t BSA::HashString(const char * str, size_t length) {
             uint32_t hash = 0;
-            for (size_t i = 0, len = str.length(); i < len; i++) {
+            for (size_t i = 0; i < length; i++) {
                 hash = 0x1003F * hash + (uint8_t)str[i];
             }
             return hash;
         }
 
-        uint64_t BSA::CalcHash(const std::string& path, const std::string& ext) {
+        uint64_t BSA::CalcHash(const char * path, size_t len, const char * ext, size_t extLength) {
             uint64_t hash1 = 0;
             uint32_t hash2 = 0;
             uint32_t hash3 = 0;
-            const size_t len = path.length();
 
-            if (!path.empty()) {
+            auto extEquals = [&](const char * knownExt) {
+                return extLength == strlen(knownExt) && memcmp(ext, knownExt, extLength) == 0;
+            };
+
+            if (len > 0) {
                 hash1 = (uint64_t)(
                     ((uint8_t)path[len - 1])
                     + (len << 16)
@@ -429,47 +751,38 @@ namespace libbsa {
                 if (len > 2) {
                     hash1 += ((uint8_t)path[len - 2] << 8);
                     if (len > 3)
-                        hash2 = HashString(path.substr(1, len - 3));
+                        hash2 = HashString(path + 1, len - 3);
                 }
             }
 
-            if (!ext.empty()) {
-                if (ext == ".kf")
+            if (extLength > 0) {
+                if (extEquals(".kf"))
                     hash1 += 0x80;
-                else if (ext == ".nif")
+                else if (extEquals(".nif"))
                     hash1 += 0x8000;
-                else if (ext == ".dds")
+                else if (extEquals(".dds"))
                     hash1 += 0x8080;
-                else if (ext == ".wav")
+                else if (extEquals(".wav"))
                     hash1 += 0x80000000;
 
-                hash3 = HashString(ext);
+                hash3 = HashString(ext, extLength);
             }
 
             hash2 = hash2 + hash3;
             return ((uint64_t)hash2 << 32) + hash1;
         }
 
-        bool BSA::hash_comp(const BsaAsset& first, const BsaAsset& second) {
-            return first.hash < second.hash;
-        }
-
-        bool BSA::path_comp(const BsaAsset& first, const BsaAsset& second) {
-            return first.path == second.path;
-        }
-
         //Check if a given file is a Tes4-type BSA.
-        bool BSA::IsBSA(const boost::filesystem::path& path) {
-            //Check if file exists.
-            if (!fs::exists(path))
+        bool BSA::IsBSA(const ArchiveFile& archiveFile) {
+            //Check if file exists and is big enough to have a header.
+            if (!archiveFile.IsOpen() || archiveFile.GetSize() < sizeof(uint32_t))
                 return false;
 
-            boost::filesystem::ifstream in(fs::path(path), ios::binary);
-            in.exceptions(ios::failbit | ios::badbit | ios::eofbit);
-
             uint32_t magic;
-            in.read((char*)&magic, sizeof(uint32_t));
-            in.close();
+            if (archiveFile.GetMapping() != NULL)
+                memcpy(&magic, archiveFile.GetMapping(), sizeof(uint32_t));
+            else
+                archiveFile.Read(0, sizeof(uint32_t), reinterpret_cast<uint8_t*>(&magic));
 
             return magic == BSA_MAGIC;
         }
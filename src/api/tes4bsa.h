@@ -27,6 +27,7 @@
 #include "genericbsa.h"
 #include <stdint.h>
 #include <string>
+#include <vector>
 #include <boost/filesystem.hpp>
 
 /* File format infos:
@@ -55,33 +56,58 @@ namespace libbsa {
 
             static const uint32_t FILE_INVERT_COMPRESSED = 0x40000000;  //Inverts the file data compression status for the specific file this flag is set for.
 
-            BSA(const boost::filesystem::path& path);
+            BSA(const boost::filesystem::path& path, ArchiveFile&& archiveFile);
             void Save(const boost::filesystem::path& path,
                       const uint32_t version,
-                      const uint32_t compression);
+                      const uint32_t compression,
+                      unsigned int threadCount);
 
             //Check if a given file is a Tes4-type BSA.
-            static bool IsBSA(const boost::filesystem::path& path);
+            static bool IsBSA(const ArchiveFile& archiveFile);
         private:
-            std::pair<uint8_t*, size_t> ReadData(std::ifstream& in,
-                                                 const BsaAsset& data) const;
-            static std::pair<uint8_t*, size_t> uncompressData(const std::string& assetPath,
-                                                              const uint8_t * data,
-                                                              size_t size);
-
-            static std::string getFolderName(const uint8_t * fileRecords,
-                                             uint32_t folderOffset);
-            static std::string getFileName(const uint8_t * fileNames,
-                                           uint32_t offset);
-
-            static uint32_t HashString(const std::string& str);
-            static uint64_t CalcHash(const std::string& assetPath, const std::string& ext);
+            bool FindAsset(const std::string& normalisedPath,
+                           BsaAsset * asset) const;
+            void LoadAssets();
+
+            uint32_t GetStoredSize(const BsaAsset& data) const;
+            bool IsCompressed(const BsaAsset& data) const;
+            std::pair<uint8_t*, size_t> UncompressData(const BsaAsset& data,
+                                                       const uint8_t * storedData,
+                                                       size_t storedSize) const;
+            void UncompressData(const BsaAsset& data,
+                                const uint8_t * storedData,
+                                size_t storedSize,
+                                const ChunkHandler& handler) const;
+
+            // Gets the data to write for the asset in an archive saved with
+            // the given zlib compression level, or -1 for no compression.
+            std::vector<uint8_t> TranscodeData(const BsaAsset& data,
+                                               int compressionLevel) const;
+
+            // Transcodes the given assets using threadCount worker threads,
+            // passing the results to the writer in order, on this thread. If
+            // threadCount is 0, one worker per hardware thread is used.
+            void TranscodeAssets(const std::vector<BsaAsset>& sourceAssets,
+                                 int compressionLevel,
+                                 unsigned int threadCount,
+                                 const std::function<void(size_t index, const std::vector<uint8_t>& data)>& writer) const;
+
+            static uint32_t HashString(const char * str, size_t length);
+            static uint64_t CalcHash(const char * path,
+                                     size_t pathLength,
+                                     const char * ext,
+                                     size_t extLength);
 
             uint32_t archiveFlags;
             uint32_t fileFlags;
 
-            static bool hash_comp(const BsaAsset& first, const BsaAsset& second);
-            static bool path_comp(const BsaAsset& first, const BsaAsset& second);
+            // An asset's transcoded folder and file names, used when saving.
+            struct SaveEntry {
+                std::string folderName;
+                std::string fileName;
+                uint64_t folderHash;
+                const BsaAsset * asset;
+            };
 
             struct Header {
                 uint32_t fileId;
@@ -106,6 +132,49 @@ namespace libbsa {
                 uint32_t size;      //Size of the data. See TES4Mod wiki page for details.
                 uint32_t offset;    //Offset to the raw file data, from byte 0.
             };
+
+            // The BSA's folders, in the order they're stored.
+            struct Folder {
+                // The folder's name, as stored.
+                const char * name;
+                uint8_t nameLength;
+                uint64_t nameHash;
+
+                uint32_t fileCount;
+
+                // The position of the folder's first file record in
+                // fileRecords, and the index of its first file.
+                uint32_t fileRecordsOffset;
+                uint32_t firstFile;
+            };
+
+            // Asset paths are only decoded when they're needed, so the BSA's
+            // file record blocks and file names are kept. They point into the
+            // memory-mapped BSA, or into recordsBuffer if it isn't mapped.
+            std::vector<uint8_t> recordsBuffer;
+            const uint8_t * fileRecords;
+            const char * fileNames;
+
+            std::vector<Folder> folders;
+
+            // Folders are sorted by name hash, as are the files in each
+            // folder, so lookups can binary search the hashes. If a BSA's
+            // records aren't sorted, or a path's hashes aren't found, lookups
+            // fall back to comparing names.
+            bool hashesSorted;
+
+            // The position of each file's name in fileNames, in the order
+            // they're stored.
+            std::vector<uint32_t> fileNameOffsets;
+
+            // Gets the given file record of the given folder.
+            FileRecord GetFileRecord(const Folder& folder, uint32_t index) const;
+
+            // Builds the asset for the given file record of the given folder,
+            // which has the given UTF-8 name.
+            BsaAsset MakeAsset(const std::string& folderName,
+                               const Folder& folder,
+                               uint32_t index) const;
         };
     }
 }
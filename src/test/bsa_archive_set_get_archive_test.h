@@ -0,0 +1,66 @@
+/*  libbsa
+
+A library for reading and writing BSA files.
+
+Copyright (C) 2012-2013    WrinklyNinja
+
+This file is part of libbsa.
+
+libbsa is free software: you can redistribute
+it and/or modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+libbsa is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with libbsa.  If not, see
+<http://www.gnu.org/licenses/>.
+*/
+#ifndef LIBBSA_TEST_BSA_ARCHIVE_SET_GET_ARCHIVE_H
+#define LIBBSA_TEST_BSA_ARCHIVE_SET_GET_ARCHIVE_H
+
+#include "bsa_archive_set_operation_test.h"
+
+namespace libbsa {
+    namespace test {
+        class bsa_archive_set_get_archive : public BsaArchiveSetOperationTest {
+        protected:
+            bsa_archive_set_get_archive() : archive(nullptr) {}
+
+            bsa_handle archive;
+        };
+
+        TEST_F(bsa_archive_set_get_archive, shouldFailIfUnininitialisedHandleIsGiven) {
+            EXPECT_EQ(LIBBSA_ERROR_INVALID_ARGS, ::bsa_archive_set_get_archive(setHandle, 0, &archive));
+        }
+
+        TEST_F(bsa_archive_set_get_archive, shouldFailIfNullHandlePointerIsGiven) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_archive_set_open(&setHandle, archivePaths, numArchives));
+
+            EXPECT_EQ(LIBBSA_ERROR_INVALID_ARGS, ::bsa_archive_set_get_archive(setHandle, 0, NULL));
+        }
+
+        TEST_F(bsa_archive_set_get_archive, shouldFailIfIndexIsOutOfRange) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_archive_set_open(&setHandle, archivePaths, numArchives));
+
+            EXPECT_EQ(LIBBSA_ERROR_INVALID_ARGS, ::bsa_archive_set_get_archive(setHandle, numArchives, &archive));
+        }
+
+        TEST_F(bsa_archive_set_get_archive, shouldOutputAHandleThatCanBeUsed) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_archive_set_open(&setHandle, archivePaths, numArchives));
+
+            EXPECT_EQ(LIBBSA_OK, ::bsa_archive_set_get_archive(setHandle, 1, &archive));
+            ASSERT_NE(nullptr, archive);
+
+            bool result = false;
+            EXPECT_EQ(LIBBSA_OK, ::bsa_contains_asset(archive, assetPath.c_str(), &result));
+            EXPECT_TRUE(result);
+        }
+    }
+}
+
+#endif
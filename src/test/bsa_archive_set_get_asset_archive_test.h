@@ -0,0 +1,86 @@
+/*  libbsa
+
+A library for reading and writing BSA files.
+
+Copyright (C) 2012-2013    WrinklyNinja
+
+This file is part of libbsa.
+
+libbsa is free software: you can redistribute
+it and/or modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+libbsa is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with libbsa.  If not, see
+<http://www.gnu.org/licenses/>.
+*/
+#ifndef LIBBSA_TEST_BSA_ARCHIVE_SET_GET_ASSET_ARCHIVE_H
+#define LIBBSA_TEST_BSA_ARCHIVE_SET_GET_ASSET_ARCHIVE_H
+
+#include "bsa_archive_set_operation_test.h"
+
+namespace libbsa {
+    namespace test {
+        class bsa_archive_set_get_asset_archive : public BsaArchiveSetOperationTest {
+        protected:
+            bsa_archive_set_get_asset_archive() : index(numArchives) {}
+
+            size_t index;
+        };
+
+        TEST_F(bsa_archive_set_get_asset_archive, shouldFailIfUnininitialisedHandleIsGiven) {
+            EXPECT_EQ(LIBBSA_ERROR_INVALID_ARGS, ::bsa_archive_set_get_asset_archive(setHandle, assetPath.c_str(), &index));
+        }
+
+        TEST_F(bsa_archive_set_get_asset_archive, shouldFailIfNullAssetPathIsGiven) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_archive_set_open(&setHandle, archivePaths, numArchives));
+
+            EXPECT_EQ(LIBBSA_ERROR_INVALID_ARGS, ::bsa_archive_set_get_asset_archive(setHandle, NULL, &index));
+        }
+
+        TEST_F(bsa_archive_set_get_asset_archive, shouldFailIfNullIndexPointerIsGiven) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_archive_set_open(&setHandle, archivePaths, numArchives));
+
+            EXPECT_EQ(LIBBSA_ERROR_INVALID_ARGS, ::bsa_archive_set_get_asset_archive(setHandle, assetPath.c_str(), NULL));
+        }
+
+        TEST_F(bsa_archive_set_get_asset_archive, shouldFailIfAssetPathIsNotFound) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_archive_set_open(&setHandle, archivePaths, numArchives));
+
+            EXPECT_EQ(LIBBSA_ERROR_INVALID_ARGS, ::bsa_archive_set_get_asset_archive(setHandle, invalidPath.string().c_str(), &index));
+        }
+
+        TEST_F(bsa_archive_set_get_asset_archive, shouldOutputTheOnlyArchiveIfOneArchiveIsGiven) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_archive_set_open(&setHandle, archivePaths, 1));
+
+            EXPECT_EQ(LIBBSA_OK, ::bsa_archive_set_get_asset_archive(setHandle, assetPath.c_str(), &index));
+
+            EXPECT_EQ(0, index);
+        }
+
+        TEST_F(bsa_archive_set_get_asset_archive, shouldOutputTheLastArchiveThatContainsTheAsset) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_archive_set_open(&setHandle, archivePaths, numArchives));
+
+            EXPECT_EQ(LIBBSA_OK, ::bsa_archive_set_get_asset_archive(setHandle, assetPath.c_str(), &index));
+
+            EXPECT_EQ(1, index);
+        }
+
+        TEST_F(bsa_archive_set_get_asset_archive, shouldOutputTheLastArchiveIfTheSameArchiveIsGivenTwice) {
+            archivePaths[1] = archivePaths[0];
+            ASSERT_EQ(LIBBSA_OK, ::bsa_archive_set_open(&setHandle, archivePaths, numArchives));
+
+            EXPECT_EQ(LIBBSA_OK, ::bsa_archive_set_get_asset_archive(setHandle, assetPath.c_str(), &index));
+
+            EXPECT_EQ(1, index);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,70 @@
+/*  libbsa
+
+A library for reading and writing BSA files.
+
+Copyright (C) 2012-2013    WrinklyNinja
+
+This file is part of libbsa.
+
+libbsa is free software: you can redistribute
+it and/or modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+libbsa is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with libbsa.  If not, see
+<http://www.gnu.org/licenses/>.
+*/
+#ifndef LIBBSA_TEST_BSA_ARCHIVE_SET_OPEN_H
+#define LIBBSA_TEST_BSA_ARCHIVE_SET_OPEN_H
+
+#include "bsa_archive_set_operation_test.h"
+
+namespace libbsa {
+    namespace test {
+        class bsa_archive_set_open : public BsaArchiveSetOperationTest {};
+
+        TEST_F(bsa_archive_set_open, shouldFailIfNullHandlePointerIsGiven) {
+            EXPECT_EQ(LIBBSA_ERROR_INVALID_ARGS, ::bsa_archive_set_open(NULL, archivePaths, numArchives));
+        }
+
+        TEST_F(bsa_archive_set_open, shouldFailIfNullPathsArrayIsGiven) {
+            EXPECT_EQ(LIBBSA_ERROR_INVALID_ARGS, ::bsa_archive_set_open(&setHandle, NULL, numArchives));
+        }
+
+        TEST_F(bsa_archive_set_open, shouldFailIfANullPathIsGiven) {
+            archivePaths[1] = NULL;
+
+            EXPECT_EQ(LIBBSA_ERROR_INVALID_ARGS, ::bsa_archive_set_open(&setHandle, archivePaths, numArchives));
+        }
+
+        TEST_F(bsa_archive_set_open, shouldFailIfANonExistentPathIsGiven) {
+            const std::string path = invalidPath.string();
+            archivePaths[1] = path.c_str();
+
+            EXPECT_EQ(LIBBSA_ERROR_INVALID_ARGS, ::bsa_archive_set_open(&setHandle, archivePaths, numArchives));
+        }
+
+        TEST_F(bsa_archive_set_open, shouldFailIfANonBsaPathIsGiven) {
+            const std::string path = nonBsaPath.string();
+            archivePaths[1] = path.c_str();
+
+            EXPECT_EQ(LIBBSA_ERROR_PARSE_FAIL, ::bsa_archive_set_open(&setHandle, archivePaths, numArchives));
+        }
+
+        TEST_F(bsa_archive_set_open, shouldSucceedIfNoPathsAreGiven) {
+            EXPECT_EQ(LIBBSA_OK, ::bsa_archive_set_open(&setHandle, NULL, 0));
+        }
+
+        TEST_F(bsa_archive_set_open, shouldSucceedIfValidPathsAreGiven) {
+            EXPECT_EQ(LIBBSA_OK, ::bsa_archive_set_open(&setHandle, archivePaths, numArchives));
+        }
+    }
+}
+
+#endif
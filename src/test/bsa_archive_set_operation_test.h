@@ -0,0 +1,57 @@
+/*  libbsa
+
+A library for reading and writing BSA files.
+
+Copyright (C) 2012-2013    WrinklyNinja
+
+This file is part of libbsa.
+
+libbsa is free software: you can redistribute
+it and/or modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+libbsa is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with libbsa.  If not, see
+<http://www.gnu.org/licenses/>.
+*/
+#ifndef LIBBSA_BSA_ARCHIVE_SET_OPERATION_TEST_H
+#define LIBBSA_BSA_ARCHIVE_SET_OPERATION_TEST_H
+
+#include "bsa_handle_operation_test.h"
+
+namespace libbsa {
+    namespace test {
+        class BsaArchiveSetOperationTest : public BsaHandleOperationTest {
+        protected:
+            BsaArchiveSetOperationTest() :
+                setHandle(nullptr),
+                tes4BsaPathString(tes4BsaPath.string()),
+                tes5BsaPathString(tes5BsaPath.string()) {
+                archivePaths[0] = tes4BsaPathString.c_str();
+                archivePaths[1] = tes5BsaPathString.c_str();
+            }
+
+            ~BsaArchiveSetOperationTest() {
+                bsa_archive_set_close(setHandle);
+            }
+
+            static const size_t numArchives = 2;
+
+            bsa_archive_set_handle setHandle;
+
+            const std::string tes4BsaPathString;
+            const std::string tes5BsaPathString;
+
+            // Both archives contain assetPath.
+            const char * archivePaths[numArchives];
+        };
+    }
+}
+
+#endif
@@ -62,6 +62,14 @@ namespace libbsa {
 
             EXPECT_EQ(assetChecksum, checksum);
         }
+
+        TEST_F(bsa_calc_checksum, shouldOutputChecksumCorrectlyForATes5Bsa) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes5BsaPath.string().c_str()));
+
+            EXPECT_EQ(LIBBSA_OK, ::bsa_calc_checksum(handle, assetPath.c_str(), &checksum));
+
+            EXPECT_EQ(assetChecksum, checksum);
+        }
     }
 }
 
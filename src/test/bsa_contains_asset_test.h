@@ -26,10 +26,57 @@ along with libbsa.  If not, see
 
 #include "bsa_handle_operation_test.h"
 
+#include <cstring>
+#include <iterator>
+#include <vector>
+
 namespace libbsa {
     namespace test {
         class bsa_contains_asset : public BsaHandleOperationTest {
         protected:
+            bsa_contains_asset() :
+                mismatchedHashesBsaPath("./mismatched_hashes.bsa") {}
+
+            void TearDown() {
+                ::bsa_close(handle);
+                handle = nullptr;
+
+                boost::filesystem::remove(mismatchedHashesBsaPath);
+            }
+
+            // Writes a copy of the Tes4-type BSA with all its file hashes set
+            // to zero, so that they're still sorted but don't match the
+            // hashes of the file names.
+            void writeMismatchedHashesBsa() {
+                boost::filesystem::ifstream in(tes4BsaPath, std::ios::binary);
+                std::vector<char> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+                in.close();
+
+                uint32_t version, flags, folderCount;
+                memcpy(&version, &data[4], sizeof(uint32_t));
+                memcpy(&flags, &data[12], sizeof(uint32_t));
+                memcpy(&folderCount, &data[16], sizeof(uint32_t));
+
+                const size_t headerSize = 36;
+                const size_t folderRecordSize = version == 0x69 ? 24 : 16;
+                size_t pos = headerSize + folderCount * folderRecordSize;
+                for (uint32_t i = 0; i < folderCount; ++i) {
+                    uint32_t fileCount;
+                    memcpy(&fileCount, &data[headerSize + i * folderRecordSize + sizeof(uint64_t)], sizeof(uint32_t));
+
+                    // Skip the folder name, if it's stored.
+                    if (flags & 0x1)
+                        pos += 1 + uint8_t(data[pos]);
+
+                    for (uint32_t j = 0; j < fileCount; ++j, pos += 16)
+                        memset(&data[pos], 0, sizeof(uint64_t));
+                }
+
+                boost::filesystem::ofstream out(mismatchedHashesBsaPath, std::ios::binary);
+                out.write(data.data(), data.size());
+            }
+
+            const boost::filesystem::path mismatchedHashesBsaPath;
             bool result;
         };
 
@@ -64,6 +111,21 @@ namespace libbsa {
 
             EXPECT_TRUE(result);
         }
+
+        TEST_F(bsa_contains_asset, shouldFindAssetsWithMismatchedHashesBeforeAndAfterTheAssetsAreListed) {
+            writeMismatchedHashesBsa();
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, mismatchedHashesBsaPath.string().c_str()));
+
+            EXPECT_EQ(LIBBSA_OK, ::bsa_contains_asset(handle, assetPath.c_str(), &result));
+            EXPECT_TRUE(result);
+
+            const char * const * assetPaths = nullptr;
+            size_t numAssets = 0;
+            ASSERT_EQ(LIBBSA_OK, ::bsa_get_assets(handle, ".*", &assetPaths, &numAssets));
+
+            EXPECT_EQ(LIBBSA_OK, ::bsa_contains_asset(handle, assetPath.c_str(), &result));
+            EXPECT_TRUE(result);
+        }
     }
 }
 
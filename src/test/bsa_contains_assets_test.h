@@ -0,0 +1,113 @@
+/*  libbsa
+
+A library for reading and writing BSA files.
+
+Copyright (C) 2012-2013    WrinklyNinja
+
+This file is part of libbsa.
+
+libbsa is free software: you can redistribute
+it and/or modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+libbsa is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with libbsa.  If not, see
+<http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LIBBSA_TEST_BSA_CONTAINS_ASSETS_H
+#define LIBBSA_TEST_BSA_CONTAINS_ASSETS_H
+
+#include "bsa_handle_operation_test.h"
+
+namespace libbsa {
+    namespace test {
+        class bsa_contains_assets : public BsaHandleOperationTest {
+        protected:
+            bsa_contains_assets() :
+                upperCasePath("LICENSE"),
+                slashPath("/license"),
+                missingPath("missing") {
+                assetPaths[0] = missingPath.c_str();
+                assetPaths[1] = assetPath.c_str();
+                assetPaths[2] = upperCasePath.c_str();
+                assetPaths[3] = missingPath.c_str();
+                assetPaths[4] = slashPath.c_str();
+            }
+
+            static const size_t numAssets = 5;
+
+            const std::string upperCasePath;
+            const std::string slashPath;
+            const std::string missingPath;
+
+            const char * assetPaths[numAssets];
+            bool results[numAssets];
+        };
+
+        TEST_F(bsa_contains_assets, shouldFailIfUnininitialisedHandleIsGiven) {
+            EXPECT_EQ(LIBBSA_ERROR_INVALID_ARGS, ::bsa_contains_assets(handle, assetPaths, numAssets, results));
+        }
+
+        TEST_F(bsa_contains_assets, shouldFailIfNullAssetPathsArrayIsGiven) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+
+            EXPECT_EQ(LIBBSA_ERROR_INVALID_ARGS, ::bsa_contains_assets(handle, NULL, numAssets, results));
+        }
+
+        TEST_F(bsa_contains_assets, shouldFailIfANullAssetPathIsGiven) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+
+            assetPaths[2] = NULL;
+            EXPECT_EQ(LIBBSA_ERROR_INVALID_ARGS, ::bsa_contains_assets(handle, assetPaths, numAssets, results));
+        }
+
+        TEST_F(bsa_contains_assets, shouldFailIfNullResultsArrayIsGiven) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+
+            EXPECT_EQ(LIBBSA_ERROR_INVALID_ARGS, ::bsa_contains_assets(handle, assetPaths, numAssets, NULL));
+        }
+
+        TEST_F(bsa_contains_assets, shouldSucceedIfNoAssetPathsAreGiven) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+
+            EXPECT_EQ(LIBBSA_OK, ::bsa_contains_assets(handle, NULL, 0, NULL));
+        }
+
+        TEST_F(bsa_contains_assets, shouldOutputWhetherEachAssetPathIsFound) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+
+            EXPECT_EQ(LIBBSA_OK, ::bsa_contains_assets(handle, assetPaths, numAssets, results));
+
+            EXPECT_FALSE(results[0]);
+            EXPECT_TRUE(results[1]);
+            EXPECT_TRUE(results[2]);
+            EXPECT_FALSE(results[3]);
+            EXPECT_TRUE(results[4]);
+        }
+
+        TEST_F(bsa_contains_assets, shouldGiveTheSameResultsOnceAssetsAreLoaded) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+
+            const char * const * loadedPaths = nullptr;
+            size_t numLoaded = 0;
+            ASSERT_EQ(LIBBSA_OK, ::bsa_get_assets(handle, assetRegex.c_str(), &loadedPaths, &numLoaded));
+
+            EXPECT_EQ(LIBBSA_OK, ::bsa_contains_assets(handle, assetPaths, numAssets, results));
+
+            EXPECT_FALSE(results[0]);
+            EXPECT_TRUE(results[1]);
+            EXPECT_TRUE(results[2]);
+            EXPECT_FALSE(results[3]);
+            EXPECT_TRUE(results[4]);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,93 @@
+/*  libbsa
+
+A library for reading and writing BSA files.
+
+Copyright (C) 2012-2013    WrinklyNinja
+
+This file is part of libbsa.
+
+libbsa is free software: you can redistribute
+it and/or modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+libbsa is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with libbsa.  If not, see
+<http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LIBBSA_TEST_BSA_EXTRACT_ASSET_TO_CALLBACK_H
+#define LIBBSA_TEST_BSA_EXTRACT_ASSET_TO_CALLBACK_H
+
+#include "bsa_handle_operation_test.h"
+
+namespace libbsa {
+    namespace test {
+        class bsa_extract_asset_to_callback : public BsaHandleOperationTest {
+        protected:
+            struct CallbackData {
+                CallbackData() : calls(0), size(0) {}
+
+                boost::crc_32_type crc;
+                size_t calls;
+                size_t size;
+            };
+
+            inline static void callback(const uint8_t * data, size_t size, void * userData) {
+                CallbackData * callbackData = static_cast<CallbackData*>(userData);
+
+                callbackData->crc.process_bytes(data, size);
+                callbackData->calls++;
+                callbackData->size += size;
+            }
+
+            CallbackData callbackData;
+        };
+
+        TEST_F(bsa_extract_asset_to_callback, shouldFailIfUnininitialisedHandleIsGiven) {
+            EXPECT_EQ(LIBBSA_ERROR_INVALID_ARGS, ::bsa_extract_asset_to_callback(handle, assetPath.c_str(), callback, &callbackData));
+        }
+
+        TEST_F(bsa_extract_asset_to_callback, shouldFailIfNullAssetPathIsGiven) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+
+            EXPECT_EQ(LIBBSA_ERROR_INVALID_ARGS, ::bsa_extract_asset_to_callback(handle, NULL, callback, &callbackData));
+        }
+
+        TEST_F(bsa_extract_asset_to_callback, shouldFailIfNullCallbackIsGiven) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+
+            EXPECT_EQ(LIBBSA_ERROR_INVALID_ARGS, ::bsa_extract_asset_to_callback(handle, assetPath.c_str(), NULL, &callbackData));
+        }
+
+        TEST_F(bsa_extract_asset_to_callback, shouldFailIfAssetPathDoesNotExist) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+
+            EXPECT_EQ(LIBBSA_ERROR_INVALID_ARGS, ::bsa_extract_asset_to_callback(handle, invalidPath.string().c_str(), callback, &callbackData));
+            EXPECT_EQ(0, callbackData.calls);
+        }
+
+        TEST_F(bsa_extract_asset_to_callback, shouldPassAssetDataToCallbackCorrectly) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+
+            EXPECT_EQ(LIBBSA_OK, ::bsa_extract_asset_to_callback(handle, assetPath.c_str(), callback, &callbackData));
+
+            EXPECT_NE(0, callbackData.calls);
+            EXPECT_NE(0, callbackData.size);
+            EXPECT_EQ(assetChecksum, callbackData.crc.checksum());
+        }
+
+        TEST_F(bsa_extract_asset_to_callback, shouldAllowNullUserData) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+
+            EXPECT_EQ(LIBBSA_OK, ::bsa_extract_asset_to_callback(handle, assetPath.c_str(), [](const uint8_t *, size_t, void *) {}, NULL));
+        }
+    }
+}
+
+#endif
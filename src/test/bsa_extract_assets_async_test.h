@@ -0,0 +1,180 @@
+/*  libbsa
+
+A library for reading and writing BSA files.
+
+Copyright (C) 2012-2013    WrinklyNinja
+
+This file is part of libbsa.
+
+libbsa is free software: you can redistribute
+it and/or modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+libbsa is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with libbsa.  If not, see
+<http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LIBBSA_TEST_BSA_EXTRACT_ASSETS_ASYNC_H
+#define LIBBSA_TEST_BSA_EXTRACT_ASSETS_ASYNC_H
+
+#include "bsa_handle_operation_test.h"
+
+#include <mutex>
+#include <vector>
+
+namespace libbsa {
+    namespace test {
+        class bsa_extract_assets_async : public BsaHandleOperationTest {
+        protected:
+            struct CallbackData {
+                CallbackData() : calls(0) {}
+
+                std::mutex mutex;
+                size_t calls;
+                std::vector<size_t> indices;
+                std::vector<unsigned int> returnCodes;
+                std::vector<uint32_t> checksums;
+            };
+
+            bsa_extract_assets_async() :
+                extraction(nullptr) {}
+
+            ~bsa_extract_assets_async() {
+                bsa_extraction_close(extraction);
+            }
+
+            inline static void callback(size_t index, unsigned int returnCode, const uint8_t * data, size_t size, void * userData) {
+                CallbackData * callbackData = static_cast<CallbackData*>(userData);
+
+                boost::crc_32_type crc;
+                if (data != NULL)
+                    crc.process_bytes(data, size);
+
+                std::lock_guard<std::mutex> lock(callbackData->mutex);
+                callbackData->calls++;
+                callbackData->indices.push_back(index);
+                callbackData->returnCodes.push_back(returnCode);
+                callbackData->checksums.push_back(crc.checksum());
+            }
+
+            bsa_extraction_handle extraction;
+            CallbackData callbackData;
+        };
+
+        TEST_F(bsa_extract_assets_async, shouldFailIfUnininitialisedHandleIsGiven) {
+            const char * paths[] = { assetPath.c_str() };
+
+            EXPECT_EQ(LIBBSA_ERROR_INVALID_ARGS, ::bsa_extract_assets_async(handle, paths, 1, callback, &callbackData, &extraction));
+            EXPECT_EQ(NULL, extraction);
+        }
+
+        TEST_F(bsa_extract_assets_async, shouldFailIfNullAssetPathsArrayIsGiven) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+
+            EXPECT_EQ(LIBBSA_ERROR_INVALID_ARGS, ::bsa_extract_assets_async(handle, NULL, 1, callback, &callbackData, &extraction));
+            EXPECT_EQ(NULL, extraction);
+        }
+
+        TEST_F(bsa_extract_assets_async, shouldFailIfNullAssetPathIsGiven) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+            const char * paths[] = { assetPath.c_str(), NULL };
+
+            EXPECT_EQ(LIBBSA_ERROR_INVALID_ARGS, ::bsa_extract_assets_async(handle, paths, 2, callback, &callbackData, &extraction));
+            EXPECT_EQ(NULL, extraction);
+        }
+
+        TEST_F(bsa_extract_assets_async, shouldFailIfNullCallbackIsGiven) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+            const char * paths[] = { assetPath.c_str() };
+
+            EXPECT_EQ(LIBBSA_ERROR_INVALID_ARGS, ::bsa_extract_assets_async(handle, paths, 1, NULL, &callbackData, &extraction));
+            EXPECT_EQ(NULL, extraction);
+        }
+
+        TEST_F(bsa_extract_assets_async, shouldFailIfNullExtractionHandlePointerIsGiven) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+            const char * paths[] = { assetPath.c_str() };
+
+            EXPECT_EQ(LIBBSA_ERROR_INVALID_ARGS, ::bsa_extract_assets_async(handle, paths, 1, callback, &callbackData, NULL));
+        }
+
+        TEST_F(bsa_extract_assets_async, shouldCompleteWithoutCallingTheCallbackIfNoAssetsAreGiven) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+
+            ASSERT_EQ(LIBBSA_OK, ::bsa_extract_assets_async(handle, NULL, 0, callback, &callbackData, &extraction));
+            EXPECT_EQ(LIBBSA_OK, ::bsa_extraction_wait(extraction));
+
+            bool complete = false;
+            EXPECT_EQ(LIBBSA_OK, ::bsa_extraction_is_complete(extraction, &complete));
+            EXPECT_TRUE(complete);
+            EXPECT_EQ(0, callbackData.calls);
+        }
+
+        TEST_F(bsa_extract_assets_async, shouldPassEachAssetToTheCallbackWithItsIndex) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+            const std::string missingPath = invalidPath.string();
+            const char * paths[] = { assetPath.c_str(), missingPath.c_str(), assetPath.c_str() };
+
+            ASSERT_EQ(LIBBSA_OK, ::bsa_extract_assets_async(handle, paths, 3, callback, &callbackData, &extraction));
+            EXPECT_EQ(LIBBSA_OK, ::bsa_extraction_wait(extraction));
+
+            ASSERT_EQ(3, callbackData.calls);
+            for (size_t i = 0; i < callbackData.calls; ++i) {
+                if (callbackData.indices[i] == 1) {
+                    EXPECT_EQ(LIBBSA_ERROR_INVALID_ARGS, callbackData.returnCodes[i]);
+                }
+                else {
+                    EXPECT_EQ(LIBBSA_OK, callbackData.returnCodes[i]);
+                    EXPECT_EQ(assetChecksum, callbackData.checksums[i]);
+                }
+            }
+        }
+
+        TEST_F(bsa_extract_assets_async, shouldUseTheExtractionThreadCount) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes5BsaPath.string().c_str()));
+            ASSERT_EQ(LIBBSA_OK, ::bsa_set_extraction_threads(handle, 4));
+            std::vector<const char *> paths(16, assetPath.c_str());
+
+            ASSERT_EQ(LIBBSA_OK, ::bsa_extract_assets_async(handle, paths.data(), paths.size(), callback, &callbackData, &extraction));
+            EXPECT_EQ(LIBBSA_OK, ::bsa_extraction_wait(extraction));
+
+            ASSERT_EQ(paths.size(), callbackData.calls);
+            for (size_t i = 0; i < callbackData.calls; ++i) {
+                EXPECT_EQ(LIBBSA_OK, callbackData.returnCodes[i]);
+                EXPECT_EQ(assetChecksum, callbackData.checksums[i]);
+            }
+        }
+
+        TEST_F(bsa_extract_assets_async, closingShouldWaitForTheExtractionToStop) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+            std::vector<const char *> paths(64, assetPath.c_str());
+
+            ASSERT_EQ(LIBBSA_OK, ::bsa_extract_assets_async(handle, paths.data(), paths.size(), callback, &callbackData, &extraction));
+            ::bsa_extraction_close(extraction);
+            extraction = nullptr;
+
+            std::lock_guard<std::mutex> lock(callbackData.mutex);
+            EXPECT_GE(paths.size(), callbackData.calls);
+        }
+
+        TEST_F(bsa_extract_assets_async, isCompleteShouldFailIfNullResultPointerIsGiven) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+
+            ASSERT_EQ(LIBBSA_OK, ::bsa_extract_assets_async(handle, NULL, 0, callback, &callbackData, &extraction));
+            EXPECT_EQ(LIBBSA_ERROR_INVALID_ARGS, ::bsa_extraction_is_complete(extraction, NULL));
+        }
+
+        TEST_F(bsa_extract_assets_async, waitShouldFailIfNullHandleIsGiven) {
+            EXPECT_EQ(LIBBSA_ERROR_INVALID_ARGS, ::bsa_extraction_wait(NULL));
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,89 @@
+/*  libbsa
+
+A library for reading and writing BSA files.
+
+Copyright (C) 2012-2013    WrinklyNinja
+
+This file is part of libbsa.
+
+libbsa is free software: you can redistribute
+it and/or modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+libbsa is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with libbsa.  If not, see
+<http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LIBBSA_TEST_BSA_GET_ASSET_CACHE_STATS_H
+#define LIBBSA_TEST_BSA_GET_ASSET_CACHE_STATS_H
+
+#include "bsa_handle_operation_test.h"
+
+namespace libbsa {
+    namespace test {
+        class bsa_get_asset_cache_stats : public BsaHandleOperationTest {
+        protected:
+            bsa_get_asset_cache_stats() :
+                hits(1),
+                misses(1),
+                size(1) {}
+
+            uint64_t hits;
+            uint64_t misses;
+            size_t size;
+        };
+
+        TEST_F(bsa_get_asset_cache_stats, shouldFailIfUnininitialisedHandleIsGiven) {
+            EXPECT_EQ(LIBBSA_ERROR_INVALID_ARGS, ::bsa_get_asset_cache_stats(handle, &hits, &misses, &size));
+        }
+
+        TEST_F(bsa_get_asset_cache_stats, shouldFailIfNullHitsPointerIsGiven) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+
+            EXPECT_EQ(LIBBSA_ERROR_INVALID_ARGS, ::bsa_get_asset_cache_stats(handle, NULL, &misses, &size));
+        }
+
+        TEST_F(bsa_get_asset_cache_stats, shouldFailIfNullMissesPointerIsGiven) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+
+            EXPECT_EQ(LIBBSA_ERROR_INVALID_ARGS, ::bsa_get_asset_cache_stats(handle, &hits, NULL, &size));
+        }
+
+        TEST_F(bsa_get_asset_cache_stats, shouldFailIfNullSizePointerIsGiven) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+
+            EXPECT_EQ(LIBBSA_ERROR_INVALID_ARGS, ::bsa_get_asset_cache_stats(handle, &hits, &misses, NULL));
+        }
+
+        TEST_F(bsa_get_asset_cache_stats, shouldOutputZeroesForANewHandle) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+
+            EXPECT_EQ(LIBBSA_OK, ::bsa_get_asset_cache_stats(handle, &hits, &misses, &size));
+
+            EXPECT_EQ(0, hits);
+            EXPECT_EQ(0, misses);
+            EXPECT_EQ(0, size);
+        }
+
+        TEST_F(bsa_get_asset_cache_stats, shouldNotCountReadsWhileTheCacheIsDisabled) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes5BsaPath.string().c_str()));
+
+            uint32_t checksum = 0;
+            ASSERT_EQ(LIBBSA_OK, ::bsa_calc_checksum(handle, assetPath.c_str(), &checksum));
+            EXPECT_EQ(LIBBSA_OK, ::bsa_get_asset_cache_stats(handle, &hits, &misses, &size));
+
+            EXPECT_EQ(0, hits);
+            EXPECT_EQ(0, misses);
+            EXPECT_EQ(0, size);
+        }
+    }
+}
+
+#endif
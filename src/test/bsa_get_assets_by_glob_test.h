@@ -0,0 +1,131 @@
+/*  libbsa
+
+A library for reading and writing BSA files.
+
+Copyright (C) 2012-2013    WrinklyNinja
+
+This file is part of libbsa.
+
+libbsa is free software: you can redistribute
+it and/or modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+libbsa is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with libbsa.  If not, see
+<http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LIBBSA_TEST_BSA_GET_ASSETS_BY_GLOB_H
+#define LIBBSA_TEST_BSA_GET_ASSETS_BY_GLOB_H
+
+#include "bsa_handle_operation_test.h"
+
+#include <boost/algorithm/string.hpp>
+
+namespace libbsa {
+    namespace test {
+        class bsa_get_assets_by_glob : public BsaHandleOperationTest {
+        protected:
+            bsa_get_assets_by_glob() :
+                assetGlob("L*"),
+                noMatchAssetGlob("*.dds"),
+                assetPaths(nullptr),
+                numAssets(0) {}
+
+            const std::string assetGlob;
+            const std::string noMatchAssetGlob;
+
+            const char * const * assetPaths;
+            size_t numAssets;
+        };
+
+        TEST_F(bsa_get_assets_by_glob, shouldFailIfUnininitialisedHandleIsGiven) {
+            EXPECT_EQ(LIBBSA_ERROR_INVALID_ARGS, ::bsa_get_assets_by_glob(handle, assetGlob.c_str(), &assetPaths, &numAssets));
+
+            EXPECT_EQ(NULL, assetPaths);
+            EXPECT_EQ(0, numAssets);
+        }
+
+        TEST_F(bsa_get_assets_by_glob, shouldFailIfNullAssetGlobIsGiven) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+
+            EXPECT_EQ(LIBBSA_ERROR_INVALID_ARGS, ::bsa_get_assets_by_glob(handle, NULL, &assetPaths, &numAssets));
+        }
+
+        TEST_F(bsa_get_assets_by_glob, shouldFailIfNullAssetPathsIsGiven) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+
+            EXPECT_EQ(LIBBSA_ERROR_INVALID_ARGS, ::bsa_get_assets_by_glob(handle, assetGlob.c_str(), NULL, &numAssets));
+        }
+
+        TEST_F(bsa_get_assets_by_glob, shouldFailIfNullNumAssetsPointerIsGiven) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+
+            EXPECT_EQ(LIBBSA_ERROR_INVALID_ARGS, ::bsa_get_assets_by_glob(handle, assetGlob.c_str(), &assetPaths, NULL));
+        }
+
+        TEST_F(bsa_get_assets_by_glob, shouldOutputANullArrayPointerAndZeroSizeIfNoAssetsMatchTheAssetGlob) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+
+            EXPECT_EQ(LIBBSA_OK, ::bsa_get_assets_by_glob(handle, noMatchAssetGlob.c_str(), &assetPaths, &numAssets));
+
+            EXPECT_EQ(NULL, assetPaths);
+            EXPECT_EQ(0, numAssets);
+        }
+
+        TEST_F(bsa_get_assets_by_glob, shouldOutputMatchingPathsCorrectly) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+
+            EXPECT_EQ(LIBBSA_OK, ::bsa_get_assets_by_glob(handle, assetGlob.c_str(), &assetPaths, &numAssets));
+
+            ASSERT_EQ(1, numAssets);
+            EXPECT_EQ(boost::to_lower_copy(assetPath), assetPaths[0]);
+        }
+
+        TEST_F(bsa_get_assets_by_glob, shouldMatchSingleCharacterWildcards) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+
+            EXPECT_EQ(LIBBSA_OK, ::bsa_get_assets_by_glob(handle, "?ICENS?", &assetPaths, &numAssets));
+
+            ASSERT_EQ(1, numAssets);
+            EXPECT_EQ(boost::to_lower_copy(assetPath), assetPaths[0]);
+        }
+
+        TEST_F(bsa_get_assets_by_glob, shouldNotMatchPartialPaths) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+
+            EXPECT_EQ(LIBBSA_OK, ::bsa_get_assets_by_glob(handle, "licens", &assetPaths, &numAssets));
+
+            EXPECT_EQ(NULL, assetPaths);
+            EXPECT_EQ(0, numAssets);
+        }
+
+        TEST_F(bsa_get_assets_by_glob, shouldNotMatchPathSeparatorsWithASingleWildcard) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+
+            EXPECT_EQ(LIBBSA_OK, ::bsa_get_assets_by_glob(handle, "*\\*", &assetPaths, &numAssets));
+            EXPECT_EQ(0, numAssets);
+
+            EXPECT_EQ(LIBBSA_OK, ::bsa_get_assets_by_glob(handle, "**", &assetPaths, &numAssets));
+            EXPECT_EQ(1, numAssets);
+        }
+
+        TEST_F(bsa_get_assets_by_glob, shouldBacktrackToTheLastWildcardOnAMismatch) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+
+            EXPECT_EQ(LIBBSA_OK, ::bsa_get_assets_by_glob(handle, "l*e", &assetPaths, &numAssets));
+            EXPECT_EQ(1, numAssets);
+
+            EXPECT_EQ(LIBBSA_OK, ::bsa_get_assets_by_glob(handle, "**l**i**c**e**n**s**e**x", &assetPaths, &numAssets));
+            EXPECT_EQ(0, numAssets);
+        }
+    }
+}
+
+#endif
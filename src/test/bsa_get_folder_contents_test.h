@@ -0,0 +1,92 @@
+/*  libbsa
+
+A library for reading and writing BSA files.
+
+Copyright (C) 2012-2013    WrinklyNinja
+
+This file is part of libbsa.
+
+libbsa is free software: you can redistribute
+it and/or modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+libbsa is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with libbsa.  If not, see
+<http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LIBBSA_TEST_BSA_GET_FOLDER_CONTENTS_H
+#define LIBBSA_TEST_BSA_GET_FOLDER_CONTENTS_H
+
+#include "bsa_handle_operation_test.h"
+
+namespace libbsa {
+    namespace test {
+        class bsa_get_folder_contents : public BsaHandleOperationTest {
+        protected:
+            bsa_get_folder_contents() :
+                contentPaths(nullptr),
+                numContents(0) {}
+
+            const char * const * contentPaths;
+            size_t numContents;
+        };
+
+        TEST_F(bsa_get_folder_contents, shouldFailIfUnininitialisedHandleIsGiven) {
+            EXPECT_EQ(LIBBSA_ERROR_INVALID_ARGS, ::bsa_get_folder_contents(handle, "", &contentPaths, &numContents));
+
+            EXPECT_EQ(NULL, contentPaths);
+            EXPECT_EQ(0, numContents);
+        }
+
+        TEST_F(bsa_get_folder_contents, shouldFailIfNullFolderPathIsGiven) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+
+            EXPECT_EQ(LIBBSA_ERROR_INVALID_ARGS, ::bsa_get_folder_contents(handle, NULL, &contentPaths, &numContents));
+        }
+
+        TEST_F(bsa_get_folder_contents, shouldFailIfNullContentPathsIsGiven) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+
+            EXPECT_EQ(LIBBSA_ERROR_INVALID_ARGS, ::bsa_get_folder_contents(handle, "", NULL, &numContents));
+        }
+
+        TEST_F(bsa_get_folder_contents, shouldFailIfNullNumContentsPointerIsGiven) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+
+            EXPECT_EQ(LIBBSA_ERROR_INVALID_ARGS, ::bsa_get_folder_contents(handle, "", &contentPaths, NULL));
+        }
+
+        TEST_F(bsa_get_folder_contents, shouldFailIfFolderDoesNotExist) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+
+            EXPECT_EQ(LIBBSA_ERROR_INVALID_ARGS, ::bsa_get_folder_contents(handle, "meshes", &contentPaths, &numContents));
+
+            EXPECT_EQ(NULL, contentPaths);
+            EXPECT_EQ(0, numContents);
+        }
+
+        TEST_F(bsa_get_folder_contents, shouldFailIfAssetPathIsGiven) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+
+            EXPECT_EQ(LIBBSA_ERROR_INVALID_ARGS, ::bsa_get_folder_contents(handle, assetPath.c_str(), &contentPaths, &numContents));
+        }
+
+        TEST_F(bsa_get_folder_contents, shouldOutputRootContentsIfEmptyFolderPathIsGiven) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+
+            EXPECT_EQ(LIBBSA_OK, ::bsa_get_folder_contents(handle, "", &contentPaths, &numContents));
+
+            ASSERT_EQ(1, numContents);
+            EXPECT_EQ(assetPath, contentPaths[0]);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,87 @@
+/*  libbsa
+
+A library for reading and writing BSA files.
+
+Copyright (C) 2012-2013    WrinklyNinja
+
+This file is part of libbsa.
+
+libbsa is free software: you can redistribute
+it and/or modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+libbsa is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with libbsa.  If not, see
+<http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LIBBSA_TEST_BSA_RELEASE_ASSET_PATHS_H
+#define LIBBSA_TEST_BSA_RELEASE_ASSET_PATHS_H
+
+#include "bsa_handle_operation_test.h"
+
+#include <thread>
+
+#include <boost/algorithm/string.hpp>
+
+namespace libbsa {
+    namespace test {
+        class bsa_release_asset_paths : public BsaHandleOperationTest {
+        protected:
+            bsa_release_asset_paths() :
+                assetPaths(nullptr),
+                numAssets(0) {}
+
+            const char * const * assetPaths;
+            size_t numAssets;
+        };
+
+        TEST_F(bsa_release_asset_paths, shouldFailIfUnininitialisedHandleIsGiven) {
+            EXPECT_EQ(LIBBSA_ERROR_INVALID_ARGS, ::bsa_release_asset_paths(handle));
+        }
+
+        TEST_F(bsa_release_asset_paths, shouldSucceedIfTheThreadHasNoArray) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+
+            EXPECT_EQ(LIBBSA_OK, ::bsa_release_asset_paths(handle));
+        }
+
+        TEST_F(bsa_release_asset_paths, shouldAllowTheThreadToGetAnotherArray) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+            ASSERT_EQ(LIBBSA_OK, ::bsa_get_assets(handle, assetRegex.c_str(), &assetPaths, &numAssets));
+
+            EXPECT_EQ(LIBBSA_OK, ::bsa_release_asset_paths(handle));
+
+            ASSERT_EQ(LIBBSA_OK, ::bsa_get_assets(handle, assetRegex.c_str(), &assetPaths, &numAssets));
+            ASSERT_EQ(1, numAssets);
+            EXPECT_EQ(boost::to_lower_copy(assetPath), assetPaths[0]);
+        }
+
+        TEST_F(bsa_release_asset_paths, shouldNotFreeAnotherThreadsArray) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+            ASSERT_EQ(LIBBSA_OK, ::bsa_get_assets(handle, assetRegex.c_str(), &assetPaths, &numAssets));
+
+            unsigned int otherResult = LIBBSA_OK;
+            std::thread other([&]() {
+                const char * const * otherPaths = nullptr;
+                size_t otherNum = 0;
+                otherResult = ::bsa_get_assets(handle, assetRegex.c_str(), &otherPaths, &otherNum);
+                if (otherResult == LIBBSA_OK)
+                    otherResult = ::bsa_release_asset_paths(handle);
+            });
+            other.join();
+
+            EXPECT_EQ(LIBBSA_OK, otherResult);
+            ASSERT_EQ(1, numAssets);
+            EXPECT_EQ(boost::to_lower_copy(assetPath), assetPaths[0]);
+        }
+    }
+}
+
+#endif
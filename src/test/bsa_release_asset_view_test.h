@@ -0,0 +1,69 @@
+/*  libbsa
+
+A library for reading and writing BSA files.
+
+Copyright (C) 2012-2013    WrinklyNinja
+
+This file is part of libbsa.
+
+libbsa is free software: you can redistribute
+it and/or modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+libbsa is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with libbsa.  If not, see
+<http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LIBBSA_TEST_BSA_RELEASE_ASSET_VIEW_H
+#define LIBBSA_TEST_BSA_RELEASE_ASSET_VIEW_H
+
+#include "bsa_handle_operation_test.h"
+
+namespace libbsa {
+    namespace test {
+        class bsa_release_asset_view : public BsaHandleOperationTest {
+        protected:
+            bsa_release_asset_view() :
+                data(nullptr),
+                size(0) {}
+
+            const uint8_t * data;
+            size_t size;
+        };
+
+        TEST_F(bsa_release_asset_view, shouldFailIfUnininitialisedHandleIsGiven) {
+            uint8_t byte = 0;
+            EXPECT_EQ(LIBBSA_ERROR_INVALID_ARGS, ::bsa_release_asset_view(handle, &byte));
+        }
+
+        TEST_F(bsa_release_asset_view, shouldFailIfNullDataPointerIsGiven) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+
+            EXPECT_EQ(LIBBSA_ERROR_INVALID_ARGS, ::bsa_release_asset_view(handle, NULL));
+        }
+
+        TEST_F(bsa_release_asset_view, shouldSucceedIfAValidViewIsGiven) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+            ASSERT_EQ(LIBBSA_OK, ::bsa_get_asset_view(handle, assetPath.c_str(), &data, &size));
+
+            EXPECT_EQ(LIBBSA_OK, ::bsa_release_asset_view(handle, data));
+        }
+
+        TEST_F(bsa_release_asset_view, shouldSucceedIfAViewIsNotReleasedBeforeTheHandleIsClosed) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+            ASSERT_EQ(LIBBSA_OK, ::bsa_get_asset_view(handle, assetPath.c_str(), &data, &size));
+
+            EXPECT_NO_THROW(bsa_close(handle));
+            handle = nullptr;
+        }
+    }
+}
+
+#endif
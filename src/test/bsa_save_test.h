@@ -34,7 +34,13 @@ namespace libbsa {
                 tempBsaPath("./temp.bsa"),
                 newBsaPath("./new.bsa") {}
 
-            ~bsa_save() {
+            void TearDown() {
+                // Close the handle first, so that the files can be removed
+                // even if it has one of them open.
+                ::bsa_close(handle);
+                handle = nullptr;
+
+                boost::filesystem::remove(tempBsaPath);
                 boost::filesystem::remove(newBsaPath);
             }
 
@@ -101,6 +107,35 @@ namespace libbsa {
             EXPECT_TRUE(boost::filesystem::exists(newBsaPath));
             EXPECT_EQ(getChecksum(tes4BsaPath), getChecksum(newBsaPath));
         }
+
+        TEST_F(bsa_save, shouldCompressAssetsIfACompressionLevelIsGiven) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+
+            EXPECT_EQ(LIBBSA_OK, ::bsa_save(handle, newBsaPath.string().c_str(), LIBBSA_VERSION_TES4 | LIBBSA_COMPRESS_LEVEL_9));
+            ::bsa_close(handle);
+            handle = nullptr;
+
+            EXPECT_LT(boost::filesystem::file_size(newBsaPath), boost::filesystem::file_size(tes4BsaPath));
+
+            uint32_t checksum;
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, newBsaPath.string().c_str()));
+            EXPECT_EQ(LIBBSA_OK, ::bsa_calc_checksum(handle, assetPath.c_str(), &checksum));
+            EXPECT_EQ(assetChecksum, checksum);
+        }
+
+        TEST_F(bsa_save, shouldDecompressAssetsIfCompressionLevelZeroIsGiven) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+            ASSERT_EQ(LIBBSA_OK, ::bsa_save(handle, tempBsaPath.string().c_str(), LIBBSA_VERSION_TES4 | LIBBSA_COMPRESS_LEVEL_9));
+            ::bsa_close(handle);
+            handle = nullptr;
+
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tempBsaPath.string().c_str()));
+            EXPECT_EQ(LIBBSA_OK, ::bsa_save(handle, newBsaPath.string().c_str(), LIBBSA_VERSION_TES4 | LIBBSA_COMPRESS_LEVEL_0));
+            ::bsa_close(handle);
+            handle = nullptr;
+
+            EXPECT_EQ(getChecksum(tes4BsaPath), getChecksum(newBsaPath));
+        }
     }
 }
 
@@ -0,0 +1,135 @@
+/*  libbsa
+
+A library for reading and writing BSA files.
+
+Copyright (C) 2012-2013    WrinklyNinja
+
+This file is part of libbsa.
+
+libbsa is free software: you can redistribute
+it and/or modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+libbsa is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with libbsa.  If not, see
+<http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LIBBSA_TEST_BSA_SET_ASSET_CACHE_SIZE_H
+#define LIBBSA_TEST_BSA_SET_ASSET_CACHE_SIZE_H
+
+#include "bsa_handle_operation_test.h"
+
+namespace libbsa {
+    namespace test {
+        class bsa_set_asset_cache_size : public BsaHandleOperationTest {
+        protected:
+            bsa_set_asset_cache_size() :
+                data(nullptr),
+                size(0),
+                hits(0),
+                misses(0),
+                cachedSize(0) {}
+
+            const uint8_t * data;
+            size_t size;
+
+            uint64_t hits;
+            uint64_t misses;
+            size_t cachedSize;
+
+            inline static uint32_t getCrc(const uint8_t * const data, const size_t size) {
+                boost::crc_32_type result;
+                result.process_bytes(data, size);
+
+                return result.checksum();
+            }
+        };
+
+        TEST_F(bsa_set_asset_cache_size, shouldFailIfUnininitialisedHandleIsGiven) {
+            EXPECT_EQ(LIBBSA_ERROR_INVALID_ARGS, ::bsa_set_asset_cache_size(handle, 1024 * 1024));
+        }
+
+        TEST_F(bsa_set_asset_cache_size, shouldSucceedIfAValidHandleIsGiven) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes5BsaPath.string().c_str()));
+
+            EXPECT_EQ(LIBBSA_OK, ::bsa_set_asset_cache_size(handle, 1024 * 1024));
+        }
+
+        TEST_F(bsa_set_asset_cache_size, extractingAnAssetAgainShouldReadItFromTheCache) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes5BsaPath.string().c_str()));
+            ASSERT_EQ(LIBBSA_OK, ::bsa_set_asset_cache_size(handle, 1024 * 1024));
+
+            ASSERT_EQ(LIBBSA_OK, ::bsa_extract_asset_to_memory(handle, assetPath.c_str(), &data, &size));
+            EXPECT_EQ(assetChecksum, getCrc(data, size));
+            delete[] data;
+            ASSERT_EQ(LIBBSA_OK, ::bsa_get_asset_cache_stats(handle, &hits, &misses, &cachedSize));
+            const uint64_t firstMisses = misses;
+
+            ASSERT_EQ(LIBBSA_OK, ::bsa_extract_asset_to_memory(handle, assetPath.c_str(), &data, &size));
+            EXPECT_EQ(assetChecksum, getCrc(data, size));
+            delete[] data;
+            ASSERT_EQ(LIBBSA_OK, ::bsa_get_asset_cache_stats(handle, &hits, &misses, &cachedSize));
+
+            EXPECT_EQ(firstMisses, misses);
+            EXPECT_EQ(firstMisses, hits);
+        }
+
+        TEST_F(bsa_set_asset_cache_size, checksumsShouldBeCorrectWhenTheAssetIsCached) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes5BsaPath.string().c_str()));
+            ASSERT_EQ(LIBBSA_OK, ::bsa_set_asset_cache_size(handle, 1024 * 1024));
+
+            uint32_t checksum = 0;
+            EXPECT_EQ(LIBBSA_OK, ::bsa_calc_checksum(handle, assetPath.c_str(), &checksum));
+            EXPECT_EQ(assetChecksum, checksum);
+            EXPECT_EQ(LIBBSA_OK, ::bsa_calc_checksum(handle, assetPath.c_str(), &checksum));
+            EXPECT_EQ(assetChecksum, checksum);
+        }
+
+        TEST_F(bsa_set_asset_cache_size, assetsBiggerThanTheCacheShouldNotBeCached) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes5BsaPath.string().c_str()));
+            ASSERT_EQ(LIBBSA_OK, ::bsa_set_asset_cache_size(handle, 1));
+
+            ASSERT_EQ(LIBBSA_OK, ::bsa_extract_asset_to_memory(handle, assetPath.c_str(), &data, &size));
+            delete[] data;
+            ASSERT_EQ(LIBBSA_OK, ::bsa_get_asset_cache_stats(handle, &hits, &misses, &cachedSize));
+
+            EXPECT_EQ(0, cachedSize);
+        }
+
+        TEST_F(bsa_set_asset_cache_size, settingASizeOfZeroShouldEmptyTheCache) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes5BsaPath.string().c_str()));
+            ASSERT_EQ(LIBBSA_OK, ::bsa_set_asset_cache_size(handle, 1024 * 1024));
+            ASSERT_EQ(LIBBSA_OK, ::bsa_extract_asset_to_memory(handle, assetPath.c_str(), &data, &size));
+            delete[] data;
+
+            EXPECT_EQ(LIBBSA_OK, ::bsa_set_asset_cache_size(handle, 0));
+            ASSERT_EQ(LIBBSA_OK, ::bsa_get_asset_cache_stats(handle, &hits, &misses, &cachedSize));
+
+            EXPECT_EQ(0, cachedSize);
+        }
+
+        TEST_F(bsa_set_asset_cache_size, viewsShouldRemainValidAfterTheCacheIsEmptied) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes5BsaPath.string().c_str()));
+            ASSERT_EQ(LIBBSA_OK, ::bsa_set_asset_cache_size(handle, 1024 * 1024));
+
+            const uint8_t * otherData = nullptr;
+            size_t otherSize = 0;
+            ASSERT_EQ(LIBBSA_OK, ::bsa_get_asset_view(handle, assetPath.c_str(), &data, &size));
+            ASSERT_EQ(LIBBSA_OK, ::bsa_get_asset_view(handle, assetPath.c_str(), &otherData, &otherSize));
+            ASSERT_EQ(LIBBSA_OK, ::bsa_set_asset_cache_size(handle, 0));
+
+            EXPECT_EQ(LIBBSA_OK, ::bsa_release_asset_view(handle, otherData));
+            EXPECT_EQ(assetChecksum, getCrc(data, size));
+            EXPECT_EQ(LIBBSA_OK, ::bsa_release_asset_view(handle, data));
+        }
+    }
+}
+
+#endif
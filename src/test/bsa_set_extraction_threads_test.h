@@ -0,0 +1,91 @@
+/*  libbsa
+
+A library for reading and writing BSA files.
+
+Copyright (C) 2012-2013    WrinklyNinja
+
+This file is part of libbsa.
+
+libbsa is free software: you can redistribute
+it and/or modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+libbsa is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with libbsa.  If not, see
+<http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LIBBSA_TEST_BSA_SET_EXTRACTION_THREADS_H
+#define LIBBSA_TEST_BSA_SET_EXTRACTION_THREADS_H
+
+#include "bsa_handle_operation_test.h"
+
+#include <boost/algorithm/string.hpp>
+
+namespace libbsa {
+    namespace test {
+        class bsa_set_extraction_threads : public BsaHandleOperationTest {
+        protected:
+            bsa_set_extraction_threads() :
+                assetPaths(nullptr),
+                numAssets(0) {}
+
+            ~bsa_set_extraction_threads() {
+                boost::filesystem::remove_all(outputPath);
+            }
+
+            const char * const * assetPaths;
+            size_t numAssets;
+        };
+
+        TEST_F(bsa_set_extraction_threads, shouldFailIfUnininitialisedHandleIsGiven) {
+            EXPECT_EQ(LIBBSA_ERROR_INVALID_ARGS, ::bsa_set_extraction_threads(handle, 2));
+        }
+
+        TEST_F(bsa_set_extraction_threads, shouldSucceedIfAValidHandleIsGiven) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+
+            EXPECT_EQ(LIBBSA_OK, ::bsa_set_extraction_threads(handle, 2));
+        }
+
+        TEST_F(bsa_set_extraction_threads, extractingAssetsShouldSucceedWithMultipleThreads) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+            ASSERT_EQ(LIBBSA_OK, ::bsa_set_extraction_threads(handle, 4));
+
+            EXPECT_EQ(LIBBSA_OK, ::bsa_extract_assets(handle, assetRegex.c_str(), outputPath.string().c_str(), &assetPaths, &numAssets, false));
+
+            EXPECT_EQ(assetChecksum, getChecksum(outputPath / assetPath));
+            ASSERT_EQ(1, numAssets);
+            EXPECT_EQ(boost::to_lower_copy(assetPath), assetPaths[0]);
+        }
+
+        TEST_F(bsa_set_extraction_threads, extractingAssetsShouldSucceedWithOneThreadPerHardwareThread) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+            ASSERT_EQ(LIBBSA_OK, ::bsa_set_extraction_threads(handle, 0));
+
+            EXPECT_EQ(LIBBSA_OK, ::bsa_extract_assets(handle, assetRegex.c_str(), outputPath.string().c_str(), &assetPaths, &numAssets, false));
+
+            EXPECT_EQ(assetChecksum, getChecksum(outputPath / assetPath));
+        }
+
+        TEST_F(bsa_set_extraction_threads, extractingAssetsShouldFailWithMultipleThreadsIfOverwriteIsFalseAndDestPathAlreadyExists) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+            ASSERT_EQ(LIBBSA_OK, ::bsa_set_extraction_threads(handle, 4));
+
+            boost::filesystem::create_directories(outputPath);
+            boost::filesystem::ofstream out(outputPath / assetPath);
+            out << "test";
+            out.close();
+
+            EXPECT_EQ(LIBBSA_ERROR_FILESYSTEM_ERROR, ::bsa_extract_assets(handle, assetRegex.c_str(), outputPath.string().c_str(), &assetPaths, &numAssets, false));
+        }
+    }
+}
+
+#endif
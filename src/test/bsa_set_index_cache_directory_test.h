@@ -0,0 +1,136 @@
+/*  libbsa
+
+A library for reading and writing BSA files.
+
+Copyright (C) 2012-2013    WrinklyNinja
+
+This file is part of libbsa.
+
+libbsa is free software: you can redistribute
+it and/or modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+libbsa is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with libbsa.  If not, see
+<http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LIBBSA_TEST_BSA_SET_INDEX_CACHE_DIRECTORY_H
+#define LIBBSA_TEST_BSA_SET_INDEX_CACHE_DIRECTORY_H
+
+#include "bsa_handle_operation_test.h"
+
+#include <boost/algorithm/string.hpp>
+
+namespace libbsa {
+    namespace test {
+        class bsa_set_index_cache_directory : public BsaHandleOperationTest {
+        protected:
+            bsa_set_index_cache_directory() :
+                cachePath("./cache"),
+                assetPaths(nullptr),
+                numAssets(0) {
+                boost::filesystem::create_directories(cachePath);
+            }
+
+            ~bsa_set_index_cache_directory() {
+                ::bsa_set_index_cache_directory(NULL);
+                boost::filesystem::remove_all(cachePath);
+            }
+
+            size_t countCacheFiles() {
+                size_t count = 0;
+                for (boost::filesystem::directory_iterator it(cachePath), endIt; it != endIt; ++it)
+                    count++;
+
+                return count;
+            }
+
+            const boost::filesystem::path cachePath;
+            const char * const * assetPaths;
+            size_t numAssets;
+        };
+
+        TEST_F(bsa_set_index_cache_directory, shouldSucceedIfPassedANullPointer) {
+            EXPECT_EQ(LIBBSA_OK, ::bsa_set_index_cache_directory(NULL));
+        }
+
+        TEST_F(bsa_set_index_cache_directory, shouldFailIfPassedAPathThatIsNotADirectory) {
+            EXPECT_EQ(LIBBSA_ERROR_INVALID_ARGS, ::bsa_set_index_cache_directory(invalidPath.string().c_str()));
+            EXPECT_EQ(LIBBSA_ERROR_INVALID_ARGS, ::bsa_set_index_cache_directory(nonBsaPath.string().c_str()));
+        }
+
+        TEST_F(bsa_set_index_cache_directory, shouldNotCacheAnythingUntilAssetsAreListed) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_set_index_cache_directory(cachePath.string().c_str()));
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+
+            bool result = false;
+            ASSERT_EQ(LIBBSA_OK, ::bsa_contains_asset(handle, assetPath.c_str(), &result));
+            EXPECT_TRUE(result);
+
+            EXPECT_EQ(0, countCacheFiles());
+        }
+
+        TEST_F(bsa_set_index_cache_directory, shouldCacheTheIndexWhenAssetsAreFirstListed) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_set_index_cache_directory(cachePath.string().c_str()));
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+
+            ASSERT_EQ(LIBBSA_OK, ::bsa_get_assets(handle, assetRegex.c_str(), &assetPaths, &numAssets));
+
+            EXPECT_EQ(1, countCacheFiles());
+        }
+
+        TEST_F(bsa_set_index_cache_directory, shouldNotCacheTheIndexIfCachingIsDisabled) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_set_index_cache_directory(cachePath.string().c_str()));
+            ASSERT_EQ(LIBBSA_OK, ::bsa_set_index_cache_directory(""));
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+
+            ASSERT_EQ(LIBBSA_OK, ::bsa_get_assets(handle, assetRegex.c_str(), &assetPaths, &numAssets));
+
+            EXPECT_EQ(0, countCacheFiles());
+        }
+
+        TEST_F(bsa_set_index_cache_directory, handlesOpenedLaterShouldGetTheSameAssetsFromTheCache) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_set_index_cache_directory(cachePath.string().c_str()));
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+            ASSERT_EQ(LIBBSA_OK, ::bsa_get_assets(handle, assetRegex.c_str(), &assetPaths, &numAssets));
+            bsa_close(handle);
+            handle = nullptr;
+
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+            ASSERT_EQ(LIBBSA_OK, ::bsa_get_assets(handle, assetRegex.c_str(), &assetPaths, &numAssets));
+            ASSERT_EQ(1, numAssets);
+            EXPECT_EQ(boost::to_lower_copy(assetPath), assetPaths[0]);
+
+            uint32_t checksum = 0;
+            EXPECT_EQ(LIBBSA_OK, ::bsa_calc_checksum(handle, assetPath.c_str(), &checksum));
+            EXPECT_EQ(assetChecksum, checksum);
+        }
+
+        TEST_F(bsa_set_index_cache_directory, anInvalidCacheShouldBeIgnored) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_set_index_cache_directory(cachePath.string().c_str()));
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+            ASSERT_EQ(LIBBSA_OK, ::bsa_get_assets(handle, assetRegex.c_str(), &assetPaths, &numAssets));
+            bsa_close(handle);
+            handle = nullptr;
+
+            for (boost::filesystem::directory_iterator it(cachePath), endIt; it != endIt; ++it) {
+                boost::filesystem::ofstream out(it->path(), std::ios::binary | std::ios::trunc);
+                out << "invalid cache";
+            }
+
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+            ASSERT_EQ(LIBBSA_OK, ::bsa_get_assets(handle, assetRegex.c_str(), &assetPaths, &numAssets));
+            ASSERT_EQ(1, numAssets);
+            EXPECT_EQ(boost::to_lower_copy(assetPath), assetPaths[0]);
+        }
+    }
+}
+
+#endif
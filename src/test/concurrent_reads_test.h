@@ -0,0 +1,160 @@
+/*  libbsa
+
+A library for reading and writing BSA files.
+
+Copyright (C) 2012-2013    WrinklyNinja
+
+This file is part of libbsa.
+
+libbsa is free software: you can redistribute
+it and/or modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation, either version 3 of
+the License, or (at your option) any later version.
+
+libbsa is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with libbsa.  If not, see
+<http://www.gnu.org/licenses/>.
+*/
+#ifndef LIBBSA_TEST_CONCURRENT_READS_H
+#define LIBBSA_TEST_CONCURRENT_READS_H
+
+#include "bsa_handle_operation_test.h"
+
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace libbsa {
+    namespace test {
+        // Calls read functions on one handle from many threads at once. Each
+        // thread counts its failures instead of asserting, so that a failure
+        // is reported once, from the test's own thread.
+        class concurrent_reads : public BsaHandleOperationTest {
+        protected:
+            concurrent_reads() : failures(0) {}
+
+            static const unsigned int threadCount = 8;
+            static const unsigned int iterations = 200;
+
+            std::atomic<unsigned int> failures;
+
+            inline static uint32_t getCrc(const uint8_t * const data, const size_t size) {
+                boost::crc_32_type result;
+                result.process_bytes(data, size);
+
+                return result.checksum();
+            }
+
+            template<class Function>
+            void runThreads(Function function) {
+                std::vector<std::thread> threads;
+                for (unsigned int i = 0; i < threadCount; ++i) {
+                    threads.emplace_back([this, function, i]() {
+                        for (unsigned int j = 0; j < iterations; ++j) {
+                            if (!function(i))
+                                failures++;
+                        }
+                    });
+                }
+
+                for (auto& thread : threads)
+                    thread.join();
+            }
+        };
+
+        TEST_F(concurrent_reads, shouldGetTheSameResultsFromEveryThread) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+
+            runThreads([this](unsigned int) {
+                bool result = false;
+                if (::bsa_contains_asset(handle, assetPath.c_str(), &result) != LIBBSA_OK || !result)
+                    return false;
+
+                uint32_t checksum = 0;
+                if (::bsa_calc_checksum(handle, assetPath.c_str(), &checksum) != LIBBSA_OK || checksum != assetChecksum)
+                    return false;
+
+                const uint8_t * data = nullptr;
+                size_t size = 0;
+                if (::bsa_extract_asset_to_memory(handle, assetPath.c_str(), &data, &size) != LIBBSA_OK)
+                    return false;
+                checksum = getCrc(data, size);
+                delete[] data;
+                if (checksum != assetChecksum)
+                    return false;
+
+                if (::bsa_get_asset_view(handle, assetPath.c_str(), &data, &size) != LIBBSA_OK)
+                    return false;
+                checksum = getCrc(data, size);
+                if (::bsa_release_asset_view(handle, data) != LIBBSA_OK)
+                    return false;
+
+                return checksum == assetChecksum;
+            });
+
+            EXPECT_EQ(0, failures);
+        }
+
+        TEST_F(concurrent_reads, shouldNotFreeAnotherThreadsAssetArray) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+
+            runThreads([this](unsigned int i) {
+                const char * const * paths = nullptr;
+                size_t numPaths = 0;
+                unsigned int returnCode;
+                if (i % 2 == 0)
+                    returnCode = ::bsa_get_assets(handle, assetRegex.c_str(), &paths, &numPaths);
+                else
+                    returnCode = ::bsa_get_folder_contents(handle, "", &paths, &numPaths);
+                if (returnCode != LIBBSA_OK || numPaths != 1)
+                    return false;
+
+                // Give other threads a chance to replace their own arrays.
+                std::this_thread::yield();
+
+                return strcmp(paths[0], assetPath.c_str()) == 0;
+            });
+
+            EXPECT_EQ(0, failures);
+        }
+
+        TEST_F(concurrent_reads, shouldKeepEachThreadsLastErrorMessage) {
+            ASSERT_EQ(LIBBSA_OK, ::bsa_open(&handle, tes4BsaPath.string().c_str()));
+
+            runThreads([this](unsigned int i) {
+                const uint8_t * data = nullptr;
+                size_t size = 0;
+                unsigned int returnCode;
+                const char * expectedMessage;
+                if (i % 2 == 0) {
+                    returnCode = ::bsa_extract_asset_to_memory(handle, invalidPath.string().c_str(), &data, &size);
+                    expectedMessage = "Asset not found";
+                }
+                else {
+                    returnCode = ::bsa_extract_asset_to_memory(handle, NULL, &data, &size);
+                    expectedMessage = "Null pointer passed.";
+                }
+                if (returnCode != LIBBSA_ERROR_INVALID_ARGS)
+                    return false;
+
+                std::this_thread::yield();
+
+                const char * message = nullptr;
+                if (::bsa_get_error_message(&message) != LIBBSA_OK || message == nullptr)
+                    return false;
+
+                return strcmp(message, expectedMessage) == 0;
+            });
+
+            EXPECT_EQ(0, failures);
+        }
+    }
+}
+
+#endif
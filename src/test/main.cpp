@@ -26,14 +26,34 @@
 #define BOOST_NO_CXX11_SCOPED_ENUMS
 #endif
 
+#include "bsa_archive_set_contains_asset_test.h"
+#include "bsa_archive_set_extract_asset_test.h"
+#include "bsa_archive_set_extract_asset_to_memory_test.h"
+#include "bsa_archive_set_get_archive_test.h"
+#include "bsa_archive_set_get_asset_archive_test.h"
+#include "bsa_archive_set_open_test.h"
 #include "bsa_calc_checksum_test.h"
 #include "bsa_contains_asset_test.h"
+#include "bsa_contains_assets_test.h"
 #include "bsa_extract_asset_test.h"
+#include "bsa_extract_asset_to_callback_test.h"
 #include "bsa_extract_asset_to_memory_test.h"
+#include "bsa_extract_assets_async_test.h"
+#include "bsa_extract_assets_by_glob_test.h"
 #include "bsa_extract_assets_test.h"
+#include "bsa_get_asset_cache_stats_test.h"
+#include "bsa_get_asset_view_test.h"
+#include "bsa_get_assets_by_glob_test.h"
 #include "bsa_get_assets_test.h"
+#include "bsa_get_folder_contents_test.h"
 #include "bsa_open_test.h"
+#include "bsa_release_asset_paths_test.h"
+#include "bsa_release_asset_view_test.h"
 #include "bsa_save_test.h"
+#include "bsa_set_asset_cache_size_test.h"
+#include "bsa_set_extraction_threads_test.h"
+#include "bsa_set_index_cache_directory_test.h"
+#include "concurrent_reads_test.h"
 #include "libbsa_test.h"
 
 int main(int argc, char **argv) {